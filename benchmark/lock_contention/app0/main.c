@@ -0,0 +1,118 @@
+#include "../bench.h"
+
+// See plat_conf.h
+#define BOOT_PMP 0
+#define RAM_MEM 1
+#define UART_MEM 2
+#define TIME_MEM 3
+#define HART0_TIME 4
+#define HART1_TIME 5
+#define HART2_TIME 6
+#define HART3_TIME 7
+#define MONITOR 8
+#define CHANNEL 9
+
+// Free slots of app0.
+#define UART_PMP 11
+#define SHARED_PMP 12
+#define HAMMER 13
+#define TMP 15
+
+s3k_err_t setup_uart(uint64_t uart_idx)
+{
+	uint64_t uart_addr = s3k_napot_encode(UART0_BASE_ADDR, 0x8);
+	s3k_err_t err = s3k_cap_derive(UART_MEM, uart_idx,
+				       s3k_mk_pmp(uart_addr, S3K_MEM_RW));
+	if (!err)
+		err = s3k_pmp_load(uart_idx, 1);
+	s3k_sync_mem();
+	return err;
+}
+
+s3k_err_t setup_shared(void)
+{
+	uint64_t shared_addr = s3k_napot_encode(SHARED_BASE, SHARED_SIZE);
+	s3k_err_t err = s3k_cap_derive(RAM_MEM, SHARED_PMP,
+				       s3k_mk_pmp(shared_addr, S3K_MEM_RW));
+	if (!err)
+		err = s3k_pmp_load(SHARED_PMP, 2);
+	if (err)
+		return err;
+	s3k_sync_mem();
+	for (uint64_t pid = 0; pid < APP_CNT; pid++)
+		RESULTS[pid].done = 0;
+	// Capability to move around, a sibling of the other apps'.
+	return s3k_cap_derive(RAM_MEM, HAMMER,
+			      s3k_mk_pmp(shared_addr, S3K_MEM_R));
+}
+
+s3k_err_t setup_app(uint64_t pid, uint64_t time)
+{
+	// As linked by appN.ld.
+	uint64_t app_base = 0x80010000 + 0x10000 * pid;
+	uint64_t app_addr = s3k_napot_encode(app_base, 0x10000);
+	uint64_t shared_addr = s3k_napot_encode(SHARED_BASE, SHARED_SIZE);
+	s3k_err_t err;
+
+	// Main memory
+	err = s3k_cap_derive(RAM_MEM, TMP, s3k_mk_pmp(app_addr, S3K_MEM_RWX));
+	if (!err)
+		err = s3k_mon_cap_move(MONITOR, 0, TMP, pid, APP_MEM_PMP);
+	if (!err)
+		err = s3k_mon_pmp_load(MONITOR, pid, APP_MEM_PMP, 0);
+
+	// Results page
+	if (!err)
+		err = s3k_cap_derive(RAM_MEM, TMP,
+				     s3k_mk_pmp(shared_addr, S3K_MEM_RW));
+	if (!err)
+		err = s3k_mon_cap_move(MONITOR, 0, TMP, pid, APP_SHARED_PMP);
+	if (!err)
+		err = s3k_mon_pmp_load(MONITOR, pid, APP_SHARED_PMP, 1);
+
+	if (!err)
+		err = s3k_cap_derive(RAM_MEM, TMP,
+				     s3k_mk_pmp(shared_addr, S3K_MEM_R));
+	if (!err)
+		err = s3k_mon_cap_move(MONITOR, 0, TMP, pid, APP_HAMMER);
+
+	// The whole of the app's hart
+	if (!err)
+		err = s3k_mon_cap_move(MONITOR, 0, time, pid, APP_TIME);
+
+	if (!err)
+		err = s3k_mon_reg_write(MONITOR, pid, S3K_REG_PC, app_base);
+	return err;
+}
+
+int main(void)
+{
+	if (setup_uart(UART_PMP))
+		return -1;
+	s3k_err_t err = setup_shared();
+	if (err) {
+		alt_printf("shared page setup error: 0x%X\n", err);
+		return -1;
+	}
+	const uint64_t times[] = {HART1_TIME, HART2_TIME, HART3_TIME};
+	for (uint64_t pid = 1; pid < APP_CNT; pid++) {
+		err = setup_app(pid, times[pid - 1]);
+		if (err) {
+			alt_printf("app%d setup error: 0x%X\n", pid, err);
+			return -1;
+		}
+	}
+
+	alt_puts("lock contention: s3k_cap_move latency in cycles");
+	for (uint64_t pid = 1; pid < APP_CNT; pid++)
+		s3k_mon_resume(MONITOR, pid);
+	bench_run(0, HAMMER, HAMMER + 1);
+
+	for (uint64_t pid = 0; pid < APP_CNT; pid++) {
+		while (!__atomic_load_n(&RESULTS[pid].done, __ATOMIC_ACQUIRE))
+			;
+		alt_printf("hart %d: p50=%d p90=%d p99=%d max=%d\n", pid,
+			   RESULTS[pid].p50, RESULTS[pid].p90,
+			   RESULTS[pid].p99, RESULTS[pid].max);
+	}
+}
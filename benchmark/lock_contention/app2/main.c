@@ -0,0 +1,6 @@
+#include "../bench.h"
+
+int main(void)
+{
+	bench_run(s3k_get_pid(), APP_HAMMER, APP_HAMMER + 1);
+}
@@ -0,0 +1,81 @@
+/**
+ * Lock contention benchmark shared by all apps.
+ *
+ * Every app runs on its own hart and moves a capability back and forth
+ * between two of its slots. The capabilities are siblings derived from the
+ * same memory capability, so a move also locks the neighbouring apps'
+ * tables and the harts contend for the same locks. Latencies of the moves
+ * are written to a shared page, app0 prints the percentiles.
+ */
+#pragma once
+
+#include "altc/altio.h"
+#include "s3k/s3k.h"
+
+#define APP_CNT 4
+
+#define SHARED_BASE 0x80050000
+#define SHARED_SIZE 0x1000
+
+// Capabilities app0 gives app1-app3.
+#define APP_MEM_PMP 0
+#define APP_TIME 1
+#define APP_SHARED_PMP 2
+#define APP_HAMMER 3
+
+#define WARMUP 64
+#define SAMPLES 1024
+
+typedef struct result {
+	uint64_t done;
+	uint64_t p50, p90, p99, max;
+} result_t;
+
+#define RESULTS ((volatile result_t *)SHARED_BASE)
+
+static inline uint64_t rdcycle(void)
+{
+	uint64_t cycle;
+	__asm__ volatile("rdcycle %0" : "=r"(cycle));
+	return cycle;
+}
+
+static inline uint64_t move_cycles(s3k_cidx_t src, s3k_cidx_t dst)
+{
+	uint64_t start = rdcycle();
+	s3k_cap_move(src, dst);
+	return rdcycle() - start;
+}
+
+static inline void sort(uint64_t *a, uint64_t n)
+{
+	for (uint64_t i = 1; i < n; i++) {
+		uint64_t x = a[i];
+		uint64_t j = i;
+		for (; j > 0 && a[j - 1] > x; j--)
+			a[j] = a[j - 1];
+		a[j] = x;
+	}
+}
+
+static inline void bench_run(uint64_t pid, s3k_cidx_t src, s3k_cidx_t dst)
+{
+	static uint64_t samples[SAMPLES];
+
+	for (uint64_t i = 0; i < WARMUP; i++) {
+		move_cycles(src, dst);
+		move_cycles(dst, src);
+	}
+	for (uint64_t i = 0; i < SAMPLES; i += 2) {
+		samples[i] = move_cycles(src, dst);
+		samples[i + 1] = move_cycles(dst, src);
+	}
+	sort(samples, SAMPLES);
+
+	volatile result_t *res = &RESULTS[pid];
+	res->p50 = samples[SAMPLES / 2];
+	res->p90 = samples[SAMPLES * 90 / 100];
+	res->p99 = samples[SAMPLES * 99 / 100];
+	res->max = samples[SAMPLES - 1];
+	__atomic_store_n(&res->done, 1, __ATOMIC_RELEASE);
+}
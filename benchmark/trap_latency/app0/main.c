@@ -0,0 +1,109 @@
+/**
+ * Trap latency benchmark.
+ *
+ * Measures, in cycles, the round trip of a system call on the slow path of
+ * trap.S and the gap a timer preemption leaves in the process. app0 splits
+ * its time of hart 0 into single-slot slices, so each slot boundary is a
+ * timer interrupt that enters the scheduler and resumes app0. Compare
+ * against a kernel built before a trap.S change to see its effect.
+ */
+#include "altc/altio.h"
+#include "s3k/s3k.h"
+
+// See plat_conf.h
+#define BOOT_PMP 0
+#define RAM_MEM 1
+#define UART_MEM 2
+#define TIME_MEM 3
+#define HART0_TIME 4
+#define MONITOR 8
+
+// Free slots of app0.
+#define UART_PMP 10
+#define SLICE_FIRST 16
+
+#define WARMUP 64
+#define SAMPLES 1024
+// Smallest rdcycle gap counted as a preemption.
+#define GAP_MIN 200
+
+static uint64_t samples[SAMPLES];
+
+static inline uint64_t rdcycle(void)
+{
+	uint64_t cycle;
+	__asm__ volatile("rdcycle %0" : "=r"(cycle));
+	return cycle;
+}
+
+static void sort(uint64_t *a, uint64_t n)
+{
+	for (uint64_t i = 1; i < n; i++) {
+		uint64_t x = a[i];
+		uint64_t j = i;
+		for (; j > 0 && a[j - 1] > x; j--)
+			a[j] = a[j - 1];
+		a[j] = x;
+	}
+}
+
+static void report(const char *what, uint64_t *a, uint64_t n)
+{
+	sort(a, n);
+	alt_printf("%s: min=%d p50=%d p90=%d p99=%d max=%d\n", what, a[0],
+		   a[n / 2], a[n * 90 / 100], a[n * 99 / 100], a[n - 1]);
+}
+
+void setup_uart(uint64_t uart_idx)
+{
+	uint64_t uart_addr = s3k_napot_encode(UART0_BASE_ADDR, 0x8);
+	s3k_cap_derive(UART_MEM, uart_idx, s3k_mk_pmp(uart_addr, S3K_MEM_RW));
+	s3k_pmp_load(uart_idx, 1);
+	s3k_sync_mem();
+}
+
+// One slice per slot, the scheduler preempts at every slot boundary.
+void setup_slices(void)
+{
+	for (uint64_t i = 0; i < S3K_SLOT_CNT; i++)
+		s3k_cap_derive(HART0_TIME, SLICE_FIRST + i,
+			       s3k_mk_time(S3K_MIN_HART, i, i + 1));
+}
+
+void bench_ecall(void)
+{
+	for (uint64_t i = 0; i < WARMUP + SAMPLES; i++) {
+		uint64_t start = rdcycle();
+		s3k_reg_write(S3K_REG_TPC, 0);
+		uint64_t end = rdcycle();
+		if (i >= WARMUP)
+			samples[i - WARMUP] = end - start;
+	}
+	report("ecall (reg_write)", samples, SAMPLES);
+}
+
+void bench_preempt(void)
+{
+	uint64_t i = 0;
+	uint64_t prev = rdcycle();
+	while (i < WARMUP + SAMPLES) {
+		uint64_t now = rdcycle();
+		if (now - prev >= GAP_MIN) {
+			if (i >= WARMUP)
+				samples[i - WARMUP] = now - prev;
+			i++;
+		}
+		prev = now;
+	}
+	report("timer preemption", samples, SAMPLES);
+}
+
+int main(void)
+{
+	setup_uart(UART_PMP);
+	setup_slices();
+
+	alt_puts("trap latency in cycles");
+	bench_ecall();
+	bench_preempt();
+}
@@ -8,8 +8,9 @@
 
 #define VIRTIO0_BASE_ADDR (0x10001000ull)
 
-#define MTIME_BASE_ADDR 0x200bff8ull
+#define MTIME_BASE_ADDR 0x200bff8
 #define MTIMECMP_BASE_ADDR 0x2004000ull
+#define MSIP_BASE_ADDR 0x2000000ull
 
 // Min and max usable hart ID.
 #define S3K_MIN_HART 0
@@ -45,12 +45,43 @@ typedef enum {
 	S3K_SYS_CREATE_DIR,
 	S3K_SYS_PATH_DELETE,
 	S3K_SYS_READ_DIR,
+
+	// Scheduling
+	S3K_SYS_MON_SLACK_SET,
+	S3K_SYS_SCHED_STAGE,
+	S3K_SYS_SCHED_COMMIT,
+
+	// Instrumentation
+	S3K_SYS_MON_SYSHIST_READ,
+
+	// Accounting
+	S3K_SYS_MON_ACCT_READ,
+
+	// Tracing
+	S3K_SYS_MON_TRACE_READ,
+
+	// Batching
+	S3K_SYS_MULTICALL,
+
+	// Bulk capability reads
+	S3K_SYS_CAP_READ_RANGE,
+	S3K_SYS_MON_CAP_READ_RANGE,
+
+	// Capability lookup
+	S3K_SYS_CAP_FIND,
+
+	// Derivation tree
+	S3K_SYS_CAP_PARENT,
+	S3K_SYS_CAP_DESCENDANTS,
 } s3k_syscall_t;
 
 uint64_t s3k_get_pid(void);
 uint64_t s3k_get_time(void);
 uint64_t s3k_get_timeout(void);
-uint64_t s3k_get_wcet(bool reset);
+uint64_t s3k_get_wcet(void);
+uint64_t s3k_get_idle_time(s3k_hart_t hart);
+uint64_t s3k_get_lock_stat(s3k_hart_t hart, s3k_lock_t lock,
+			   s3k_lock_stat_t stat);
 uint64_t s3k_reg_read(s3k_reg_t reg);
 uint64_t s3k_reg_write(s3k_reg_t reg, uint64_t val);
 void s3k_sync();
@@ -74,6 +105,7 @@ s3k_err_t s3k_mon_cap_move(s3k_cidx_t mon_idx, s3k_pid_t src_pid, s3k_cidx_t src
 s3k_err_t s3k_mon_pmp_load(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx,
 			   s3k_pmp_slot_t pmp_slot);
 s3k_err_t s3k_mon_pmp_unload(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx);
+s3k_err_t s3k_mon_slack_set(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_hart_t hart, bool enable);
 s3k_err_t s3k_sock_send(s3k_cidx_t sock_idx, const s3k_msg_t *msg);
 s3k_reply_t s3k_sock_recv(s3k_cidx_t sock_idx, s3k_cidx_t cap_cidx);
 s3k_reply_t s3k_sock_sendrecv(s3k_cidx_t sock_idx, const s3k_msg_t *msg);
@@ -96,6 +128,8 @@ s3k_err_t s3k_try_mon_cap_move(s3k_cidx_t mon_idx, s3k_pid_t src_pid, s3k_cidx_t
 s3k_err_t s3k_try_mon_pmp_load(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx,
 			       s3k_pmp_slot_t pmp_slot);
 s3k_err_t s3k_try_mon_pmp_unload(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx);
+s3k_err_t s3k_try_mon_slack_set(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_hart_t hart,
+				bool enable);
 s3k_err_t s3k_try_sock_send(s3k_cidx_t sock_idx, const s3k_msg_t *msg);
 s3k_reply_t s3k_try_sock_recv(s3k_cidx_t sock_idx, s3k_cidx_t cap_cidx);
 s3k_reply_t s3k_try_sock_sendrecv(s3k_cidx_t sock_idx, const s3k_msg_t *msg);
@@ -145,3 +179,127 @@ s3k_err_t s3k_path_delete(s3k_cidx_t idx);
  * provided info structure.
 */
 s3k_err_t s3k_read_dir(s3k_cidx_t directory, size_t dir_entry_idx, volatile s3k_dir_entry_info_t *out);
+/**
+ * Stage a new schedule for the free slots of a time capability, those not
+ * derived to children. Until committed, derivations within these slots only
+ * change the staged schedule, the old one keeps running. Deletions and
+ * revocations take effect at once. One schedule per hart can be staged, and
+ * moving, deleting or revoking the capability publishes it at once.
+*/
+s3k_err_t s3k_sched_stage(s3k_cidx_t idx);
+s3k_err_t s3k_try_sched_stage(s3k_cidx_t idx);
+/**
+ * Make the staged schedule live at the next start of the given slot. The time
+ * capability must cover the staged slots.
+*/
+s3k_err_t s3k_sched_commit(s3k_cidx_t idx, s3k_time_slot_t slot);
+s3k_err_t s3k_try_sched_commit(s3k_cidx_t idx, s3k_time_slot_t slot);
+/**
+ * Read the latency histogram of a system call on a hart, optionally resetting
+ * it. Requires a monitor covering all processes, and a kernel built with
+ * INSTRUMENT, otherwise the histogram is empty.
+*/
+s3k_err_t s3k_mon_syshist_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_syscall_t call,
+			       s3k_syshist_t *hist, bool reset);
+s3k_err_t s3k_try_mon_syshist_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_syscall_t call,
+				   s3k_syshist_t *hist, bool reset);
+/**
+ * Read the longest system call of all harts into wcet and reset it. Requires
+ * a monitor covering all processes, since the maximum is of all processes.
+*/
+s3k_err_t s3k_mon_wcet_reset(s3k_cidx_t mon_idx, uint64_t *wcet);
+s3k_err_t s3k_try_mon_wcet_reset(s3k_cidx_t mon_idx, uint64_t *wcet);
+/**
+ * Read a lock statistic of a hart into val and reset it. Requires a monitor
+ * covering all processes, since the statistics are of all processes.
+*/
+s3k_err_t s3k_mon_lock_stat_reset(s3k_cidx_t mon_idx, s3k_hart_t hart,
+				  s3k_lock_t lock, s3k_lock_stat_t stat,
+				  uint64_t *val);
+s3k_err_t s3k_try_mon_lock_stat_reset(s3k_cidx_t mon_idx, s3k_hart_t hart,
+				      s3k_lock_t lock, s3k_lock_stat_t stat,
+				      uint64_t *val);
+/**
+ * Read the CPU accounts of a process, in ticks, see s3k_acct_t.
+*/
+s3k_err_t s3k_mon_acct_read(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_acct_t *acct);
+s3k_err_t s3k_try_mon_acct_read(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_acct_t *acct);
+/**
+ * Drain up to n records of the kernel event trace of a hart into buf, oldest
+ * first, and set cnt to the number of records. Requires a monitor covering
+ * all processes, and a kernel built with S3K_TRACE, otherwise the trace is
+ * empty. Decode the records with scripts/trace_decode.py.
+*/
+s3k_err_t s3k_mon_trace_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_trace_rec_t *buf,
+			     uint64_t n, uint64_t *cnt);
+s3k_err_t s3k_try_mon_trace_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_trace_rec_t *buf,
+				 uint64_t n, uint64_t *cnt);
+/**
+ * Operations for s3k_multicall(), the system call is made when the batch
+ * runs. Only the calls below can be batched.
+*/
+s3k_op_t s3k_op_cap_move(s3k_cidx_t src, s3k_cidx_t dst);
+s3k_op_t s3k_op_cap_delete(s3k_cidx_t idx);
+s3k_op_t s3k_op_cap_revoke(s3k_cidx_t idx);
+s3k_op_t s3k_op_cap_derive(s3k_cidx_t src, s3k_cidx_t dst, s3k_cap_t new_cap);
+s3k_op_t s3k_op_pmp_load(s3k_cidx_t pmp_idx, s3k_pmp_slot_t pmp_slot);
+s3k_op_t s3k_op_pmp_unload(s3k_cidx_t pmp_idx);
+s3k_op_t s3k_op_mon_suspend(s3k_cidx_t mon_idx, s3k_pid_t pid);
+s3k_op_t s3k_op_mon_resume(s3k_cidx_t mon_idx, s3k_pid_t pid);
+s3k_op_t s3k_op_mon_reg_write(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_reg_t reg, uint64_t val);
+s3k_op_t s3k_op_mon_cap_move(s3k_cidx_t mon_idx, s3k_pid_t src_pid, s3k_cidx_t src_idx,
+			     s3k_pid_t dst_pid, s3k_cidx_t dst_idx);
+s3k_op_t s3k_op_mon_pmp_load(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx,
+			     s3k_pmp_slot_t pmp_slot);
+s3k_op_t s3k_op_mon_pmp_unload(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx);
+/**
+ * Run n operations in one system call, in order, stopping at the first that
+ * fails. done is set to the number of completed operations, the error is that
+ * of operation done. s3k_multicall() resumes after the completed operations
+ * when preempted, s3k_try_multicall() returns S3K_ERR_PREEMPTED.
+*/
+s3k_err_t s3k_multicall(const s3k_op_t *ops, uint64_t n, uint64_t *done);
+s3k_err_t s3k_try_multicall(const s3k_op_t *ops, uint64_t n, uint64_t *done);
+/**
+ * Read the capabilities of slots [idx, idx+n) into buf in one system call,
+ * empty slots read as S3K_CAPTY_NONE. The monitor variant has the rules of
+ * s3k_mon_cap_read(), the process must be suspended.
+*/
+s3k_err_t s3k_cap_read_range(s3k_cidx_t idx, s3k_cap_t *buf, uint64_t n);
+s3k_err_t s3k_mon_cap_read_range(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t idx,
+				 s3k_cap_t *buf, uint64_t n);
+s3k_err_t s3k_try_mon_cap_read_range(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t idx,
+				     s3k_cap_t *buf, uint64_t n);
+/**
+ * Find the first slot from idx on holding a capability of the type whose bits
+ * under mask equal those of val, e.g., the socket of a channel with
+ * mask (s3k_cap_t){.sock.chan = -1}.raw and val s3k_mk_socket(chan, ...).raw.
+ * s3k_cap_find_free() finds the first empty slot. Both set found on success
+ * and return S3K_ERR_NOT_FOUND if there is no such slot.
+*/
+s3k_err_t s3k_cap_find(s3k_cidx_t idx, s3k_capty_t type, uint64_t mask, uint64_t val,
+		       s3k_cidx_t *found);
+s3k_err_t s3k_cap_find_free(s3k_cidx_t idx, s3k_cidx_t *found);
+/**
+ * Get the slot of the capability idx was derived from. Returns
+ * S3K_ERR_NOT_FOUND for an initial capability, or if the parent is held by
+ * another process.
+*/
+s3k_err_t s3k_cap_parent(s3k_cidx_t idx, s3k_cidx_t *parent);
+s3k_err_t s3k_try_cap_parent(s3k_cidx_t idx, s3k_cidx_t *parent);
+/**
+ * Count the capabilities derived from idx, directly or not, in all processes.
+ * These are the capabilities s3k_cap_revoke() would take back.
+*/
+s3k_err_t s3k_cap_descendants(s3k_cidx_t idx, uint64_t *n);
+s3k_err_t s3k_try_cap_descendants(s3k_cidx_t idx, uint64_t *n);
+#ifdef S3K_CAP_MIRROR
+/**
+ * Read the process's capabilities from its mirror of the capability table,
+ * without a trap, in s3k_cap_read() and s3k_cap_read_range(). The boot process
+ * gets read access to all mirrors as the memory capability after INIT_CAPS,
+ * the mirror of pid is at offset pid * S3K_CAP_MIRROR_SIZE and must be mapped
+ * by a loaded PMP capability. NULL reverts to system calls.
+*/
+void s3k_cap_mirror_set(const s3k_cap_mirror_t *mirror);
+#endif
@@ -52,6 +52,10 @@ typedef enum {
 	S3K_ERR_PATH_TOO_LONG,
 	S3K_ERR_PATH_EXISTS,
 	S3K_ERR_PATH_STAT,
+
+	S3K_ERR_INVALID_HART,
+	S3K_ERR_INVALID_TIME,
+	S3K_ERR_NOT_FOUND,
 } s3k_err_t;
 
 typedef enum {
@@ -85,6 +89,20 @@ typedef enum {
 	S3K_IPC_CCAP = 0x8,  // Client can send capabilities
 } s3k_ipc_perm_t;
 
+// Locks with statistics, see s3k_get_lock_stat()
+typedef enum {
+	S3K_LOCK_MCS = 0x0,   // Kernel MCS locks
+	S3K_LOCK_SCHED = 0x1, // Scheduler table writers
+} s3k_lock_t;
+
+// Lock statistics, times in cycles
+typedef enum {
+	S3K_LOCK_ACQUIRED = 0x0, // Successful acquisitions
+	S3K_LOCK_FAILED = 0x1,	 // Attempts given up on preemption
+	S3K_LOCK_SPIN = 0x2,	 // Cycles spent waiting
+	S3K_LOCK_HOLD_MAX = 0x3, // Longest time held
+} s3k_lock_stat_t;
+
 // Path permissions
 typedef enum {
 	FILE = 0x1,	  /* file or directory */
@@ -100,6 +118,53 @@ typedef struct {
 	char fname[12 + 1]; /* File name */
 } s3k_dir_entry_info_t;
 
+// System call latency histogram, see s3k_mon_syshist_read()
+#define S3K_SYSHIST_BINS 12
+#define S3K_SYSHIST_SHIFT 6
+
+typedef struct {
+	uint64_t count;			   /* Number of samples */
+	uint64_t min;			   /* Shortest sample in cycles */
+	uint64_t max;			   /* Longest sample in cycles */
+	uint64_t sum;			   /* Sum of samples in cycles */
+	uint32_t bins[S3K_SYSHIST_BINS]; /* Bin i: log2(cycles) = SHIFT + i */
+} s3k_syshist_t;
+
+// CPU accounts of a process in ticks, see s3k_mon_acct_read()
+typedef struct {
+	uint64_t run;	 /* Ticks the process held a hart */
+	uint64_t alloc;	 /* Ticks of the slices it was dispatched to */
+	uint64_t sched;	 /* Ticks of its slices spent in the scheduler */
+	uint64_t unused; /* Ticks of its slices left after an early yield */
+} s3k_acct_t;
+
+// Kernel event trace record, see s3k_mon_trace_read()
+typedef enum {
+	S3K_TRACE_SCHED,       /* pid dispatched, arg: end of its slice */
+	S3K_TRACE_PREEMPT,     /* pid preempted at the end of its slice */
+	S3K_TRACE_YIELD,       /* pid left the hart before the end of its slice */
+	S3K_TRACE_SYSCALL,     /* pid called arg */
+	S3K_TRACE_SYSCALL_RET, /* pid returned from its system call, arg: error */
+	S3K_TRACE_IPC_SEND,    /* Message to pid, arg: channel */
+	S3K_TRACE_IPC_RECV,    /* pid waits for a message, arg: channel */
+	S3K_TRACE_EXCEPTION,   /* Exception of pid, arg: mcause */
+} s3k_trace_event_t;
+
+typedef struct {
+	uint64_t time; /* Real-time clock */
+	uint32_t seq;  /* Number of the record on its hart, gaps are lost records */
+	uint16_t pid;
+	uint8_t event; /* s3k_trace_event_t */
+	uint8_t hart;
+	uint64_t arg;
+} s3k_trace_rec_t;
+
+// Operation of a batch, see s3k_multicall()
+typedef struct {
+	uint64_t call; /* s3k_syscall_t */
+	uint64_t args[8];
+} s3k_op_t;
+
 /* COPIED FROM FATFS */
 /* File attribute bits for directory entry (s3k_dir_entry_info_t.fattrib) */
 #define AM_RDO 0x01 /* Read only */
@@ -128,7 +193,9 @@ typedef union s3k_cap {
 
 	struct {
 		s3k_capty_t type : 4;
-		uint16_t _padding : 4;
+		// Lend unused time to the hart's slack process.
+		uint16_t slack : 1;
+		uint16_t _padding : 3;
 		s3k_hart_t hart;
 		s3k_time_slot_t bgn;
 		s3k_time_slot_t mrk;
@@ -189,6 +256,17 @@ typedef union s3k_cap {
 
 _Static_assert(sizeof(s3k_cap_t) == 8, "s3k_cap_t has the wrong size");
 
+#ifdef S3K_CAP_MIRROR
+// Read-only copy of a process's capabilities, see s3k_cap_mirror_set()
+typedef struct {
+	uint64_t gen; /* Odd while the kernel updates the copy */
+	s3k_cap_t caps[S3K_CAP_CNT];
+} s3k_cap_mirror_t;
+
+// Distance between the copies of consecutive processes
+#define S3K_CAP_MIRROR_SIZE (1ull << (64 - __builtin_clzll(sizeof(s3k_cap_mirror_t) - 1)))
+#endif
+
 typedef enum {
 	S3K_REG_PC,
 	S3K_REG_RA,
@@ -229,6 +307,18 @@ typedef enum {
 	S3K_REG_ECAUSE,
 	S3K_REG_EVAL,
 	S3K_REG_SERVTIME,
+	/* Performance counters, counting only while the process runs */
+	S3K_REG_CYCLE,
+	S3K_REG_INSTRET,
+	S3K_REG_HPMCOUNTER3,
+	S3K_REG_HPMCOUNTER4,
+	S3K_REG_HPMCOUNTER5,
+	S3K_REG_HPMCOUNTER6,
+	/* Events of S3K_REG_HPMCOUNTER3-6, see mhpmevent3-6 of the platform */
+	S3K_REG_HPMEVENT3,
+	S3K_REG_HPMEVENT4,
+	S3K_REG_HPMEVENT5,
+	S3K_REG_HPMEVENT6,
 	/* Special value for number of registers */
 	S3K_REG_CNT,
 } s3k_reg_t;
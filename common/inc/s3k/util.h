@@ -78,15 +78,20 @@ static void print_cap(s3k_cap_t cap)
 
 static void dump_caps_range(char *prefix, s3k_cidx_t start, s3k_cidx_t end)
 {
+	s3k_cap_t caps[S3K_CAP_CNT];
+	s3k_err_t err = s3k_cap_read_range(start, caps, end - start + 1);
+	if (err) {
+		alt_printf("%s: Error from s3k_cap_read_range: 0x%X\n", prefix, err);
+		return;
+	}
 	for (size_t i = start; i <= end; i++) {
 		alt_printf("%s: %d: ", prefix, i);
-		s3k_cap_t cap;
-		s3k_err_t err = s3k_cap_read(i, &cap);
-		if (!err) {
+		s3k_cap_t cap = caps[i - start];
+		if (cap.raw) {
 			print_cap(cap);
 			if (cap.type == S3K_CAPTY_PATH) {
 				char buf[S3K_MAX_PATH_LEN];
-				s3k_err_t err = s3k_path_read(i, buf, sizeof(buf));
+				err = s3k_path_read(i, buf, sizeof(buf));
 				if (!err) {
 					alt_putstr(" (='");
 					alt_putstr(buf);
@@ -96,7 +101,6 @@ static void dump_caps_range(char *prefix, s3k_cidx_t start, s3k_cidx_t end)
 			}
 		} else {
 			alt_putstr("NONE");
-			alt_printf(" (Error from s3k_cap_read: 0x%X)", err);
 		}
 		alt_putchar('\n');
 	}
@@ -106,17 +110,22 @@ static void mon_dump_caps_range(s3k_pid_t self_pid, s3k_cidx_t mon_idx, s3k_pid_
 				s3k_cidx_t start, s3k_cidx_t end)
 {
 	alt_printf("Dumping caps for PID %d for idx [%d,%d]:\n", pid, start, end);
+	s3k_cap_t caps[S3K_CAP_CNT];
+	s3k_err_t err = (pid == self_pid) ?
+			    s3k_cap_read_range(start, caps, end - start + 1) :
+			    s3k_mon_cap_read_range(mon_idx, pid, start, caps, end - start + 1);
+	if (err) {
+		alt_printf("Error from s3k_mon_cap_read_range: 0x%X\n", err);
+		return;
+	}
 	for (size_t i = start; i <= end; i++) {
 		alt_printf("%d: ", i);
-		s3k_cap_t cap;
-		s3k_err_t err = (pid == self_pid) ? s3k_cap_read(i, &cap) :
-						    s3k_mon_cap_read(mon_idx, pid, i, &cap);
-		if (!err) {
+		s3k_cap_t cap = caps[i - start];
+		if (cap.raw) {
 			print_cap(cap);
 			if (cap.type == S3K_CAPTY_PATH) {
 				char buf[S3K_MAX_PATH_LEN];
-				s3k_err_t err
-				    = (pid == self_pid) ?
+				err = (pid == self_pid) ?
 					  s3k_path_read(i, buf, sizeof(buf)) :
 					  s3k_mon_path_read(mon_idx, pid, i, buf, sizeof(buf));
 				if (!err) {
@@ -129,7 +138,6 @@ static void mon_dump_caps_range(s3k_pid_t self_pid, s3k_cidx_t mon_idx, s3k_pid_
 			}
 		} else {
 			alt_putstr("NONE");
-			alt_printf(" (Error from s3k_mon_cap_read: 0x%X)", err);
 		}
 		alt_putchar('\n');
 	}
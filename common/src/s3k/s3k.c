@@ -7,6 +7,10 @@ typedef union {
 
 	struct {
 		int info;
+		s3k_hart_t hart;
+		uint64_t lock;
+		uint64_t stat;
+		s3k_cidx_t mon_idx;
 	} get_info;
 
 	struct {
@@ -24,6 +28,19 @@ typedef union {
 		s3k_cap_t cap;
 	} cap;
 
+	struct {
+		s3k_cidx_t idx;
+		s3k_cap_t *buf;
+		uint64_t n;
+	} cap_range;
+
+	struct {
+		s3k_cidx_t idx;
+		uint64_t type;
+		uint64_t mask;
+		uint64_t val;
+	} cap_find;
+
 	struct {
 		s3k_cidx_t pmp_idx;
 		s3k_pmp_slot_t pmp_slot;
@@ -49,6 +66,14 @@ typedef union {
 		s3k_cidx_t dst_idx;
 	} mon_cap;
 
+	struct {
+		s3k_cidx_t mon_idx;
+		s3k_pid_t pid;
+		s3k_cidx_t idx;
+		s3k_cap_t *buf;
+		uint64_t n;
+	} mon_cap_range;
+
 	struct {
 		s3k_cidx_t mon_idx;
 		s3k_pid_t pid;
@@ -56,6 +81,44 @@ typedef union {
 		s3k_pmp_slot_t pmp_slot;
 	} mon_pmp;
 
+	struct {
+		s3k_cidx_t mon_idx;
+		s3k_pid_t pid;
+		s3k_hart_t hart;
+		bool enable;
+	} mon_slack;
+
+	struct {
+		s3k_cidx_t idx;
+		s3k_time_slot_t slot;
+	} sched;
+
+	struct {
+		s3k_cidx_t mon_idx;
+		s3k_hart_t hart;
+		uint64_t call;
+		s3k_syshist_t *hist;
+		bool reset;
+	} mon_syshist;
+
+	struct {
+		s3k_cidx_t mon_idx;
+		s3k_pid_t pid;
+		s3k_acct_t *acct;
+	} mon_acct;
+
+	struct {
+		s3k_cidx_t mon_idx;
+		s3k_hart_t hart;
+		s3k_trace_rec_t *buf;
+		uint64_t n;
+	} mon_trace;
+
+	struct {
+		const s3k_op_t *ops;
+		uint64_t n;
+	} multicall;
+
 	struct {
 		s3k_cidx_t sock_idx;
 		s3k_cidx_t cap_idx;
@@ -404,12 +467,66 @@ uint64_t s3k_get_timeout(void)
 	return do_ecall(S3K_SYS_GET_INFO, args).val;
 }
 
-uint64_t s3k_get_wcet(bool reset)
+uint64_t s3k_get_wcet(void)
 {
-	sys_args_t args = {.get_info = {reset ? 4 : 3}};
+	sys_args_t args = {.get_info = {3}};
 	return do_ecall(S3K_SYS_GET_INFO, args).val;
 }
 
+s3k_err_t s3k_try_mon_wcet_reset(s3k_cidx_t mon_idx, uint64_t *wcet)
+{
+	sys_args_t args = {.get_info = {4, .mon_idx = mon_idx}};
+	s3k_ret_t ret = do_ecall(S3K_SYS_GET_INFO, args);
+	if (!ret.err)
+		*wcet = ret.val;
+	return ret.err;
+}
+
+s3k_err_t s3k_mon_wcet_reset(s3k_cidx_t mon_idx, uint64_t *wcet)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_mon_wcet_reset(mon_idx, wcet);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+uint64_t s3k_get_idle_time(s3k_hart_t hart)
+{
+	sys_args_t args = {.get_info = {5, hart}};
+	return do_ecall(S3K_SYS_GET_INFO, args).val;
+}
+
+uint64_t s3k_get_lock_stat(s3k_hart_t hart, s3k_lock_t lock,
+			   s3k_lock_stat_t stat)
+{
+	sys_args_t args = {.get_info = {6, hart, lock, stat}};
+	return do_ecall(S3K_SYS_GET_INFO, args).val;
+}
+
+s3k_err_t s3k_try_mon_lock_stat_reset(s3k_cidx_t mon_idx, s3k_hart_t hart,
+				      s3k_lock_t lock, s3k_lock_stat_t stat,
+				      uint64_t *val)
+{
+	sys_args_t args = {.get_info = {7, hart, lock, stat, mon_idx}};
+	s3k_ret_t ret = do_ecall(S3K_SYS_GET_INFO, args);
+	if (!ret.err)
+		*val = ret.val;
+	return ret.err;
+}
+
+s3k_err_t s3k_mon_lock_stat_reset(s3k_cidx_t mon_idx, s3k_hart_t hart,
+				  s3k_lock_t lock, s3k_lock_stat_t stat,
+				  uint64_t *val)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_mon_lock_stat_reset(mon_idx, hart, lock, stat,
+						  val);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
 uint64_t s3k_reg_read(s3k_reg_t reg)
 {
 	sys_args_t args = {.reg = {reg}};
@@ -436,8 +553,41 @@ void s3k_sync_mem(void)
 	do_ecall(S3K_SYS_SYNC, args);
 }
 
+#ifdef S3K_CAP_MIRROR
+static const s3k_cap_mirror_t *cap_mirror;
+
+void s3k_cap_mirror_set(const s3k_cap_mirror_t *mirror)
+{
+	cap_mirror = mirror;
+}
+
+static void cap_mirror_read(s3k_cidx_t idx, s3k_cap_t *buf, uint64_t n)
+{
+	// Retry until the copies are from the same generation.
+	uint64_t gen;
+	do {
+		gen = __atomic_load_n(&cap_mirror->gen, __ATOMIC_ACQUIRE);
+		for (uint64_t i = 0; i < n; i++)
+			buf[i].raw = __atomic_load_n(&cap_mirror->caps[idx + i].raw, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((gen & 1) || gen != __atomic_load_n(&cap_mirror->gen, __ATOMIC_RELAXED));
+}
+#endif
+
 s3k_err_t s3k_cap_read(s3k_cidx_t idx, s3k_cap_t *cap)
 {
+#ifdef S3K_CAP_MIRROR
+	if (cap_mirror) {
+		s3k_cap_t c;
+		if (idx >= S3K_CAP_CNT)
+			return S3K_ERR_INVALID_INDEX;
+		cap_mirror_read(idx, &c, 1);
+		if (!c.raw)
+			return S3K_ERR_EMPTY;
+		*cap = c;
+		return S3K_SUCCESS;
+	}
+#endif
 	sys_args_t args = {.cap = {idx}};
 	s3k_ret_t ret = do_ecall(S3K_SYS_CAP_READ, args);
 	if (!ret.err)
@@ -591,6 +741,15 @@ s3k_err_t s3k_mon_pmp_unload(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_i
 	return err;
 }
 
+s3k_err_t s3k_mon_slack_set(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_hart_t hart, bool enable)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_mon_slack_set(mon_idx, pid, hart, enable);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
 s3k_err_t s3k_sock_send(s3k_cidx_t sock_idx, const s3k_msg_t *msg)
 {
 	s3k_err_t err;
@@ -750,6 +909,15 @@ s3k_err_t s3k_try_mon_pmp_unload(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t p
 	return do_ecall(S3K_SYS_MON_PMP_UNLOAD, args).err;
 }
 
+s3k_err_t s3k_try_mon_slack_set(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_hart_t hart,
+				bool enable)
+{
+	sys_args_t args = {
+	    .mon_slack = {mon_idx, pid, hart, enable}
+	};
+	return do_ecall(S3K_SYS_MON_SLACK_SET, args).err;
+}
+
 s3k_err_t s3k_try_sock_send(s3k_cidx_t sock_idx, const s3k_msg_t *msg)
 {
 	sys_args_t args = {
@@ -921,3 +1089,295 @@ s3k_err_t s3k_read_dir(s3k_cidx_t directory, size_t dir_entry_idx, volatile s3k_
 	     };
 	return do_ecall(S3K_SYS_READ_DIR, args).err;
 }
+
+s3k_err_t s3k_try_sched_stage(s3k_cidx_t idx)
+{
+	sys_args_t args = {.sched = {idx}};
+	return do_ecall(S3K_SYS_SCHED_STAGE, args).err;
+}
+
+s3k_err_t s3k_sched_stage(s3k_cidx_t idx)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_sched_stage(idx);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+s3k_err_t s3k_try_sched_commit(s3k_cidx_t idx, s3k_time_slot_t slot)
+{
+	sys_args_t args = {.sched = {idx, slot}};
+	return do_ecall(S3K_SYS_SCHED_COMMIT, args).err;
+}
+
+s3k_err_t s3k_sched_commit(s3k_cidx_t idx, s3k_time_slot_t slot)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_sched_commit(idx, slot);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+s3k_err_t s3k_try_mon_syshist_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_syscall_t call,
+				   s3k_syshist_t *hist, bool reset)
+{
+	sys_args_t args = {.mon_syshist = {mon_idx, hart, call, hist, reset}};
+	return do_ecall(S3K_SYS_MON_SYSHIST_READ, args).err;
+}
+
+s3k_err_t s3k_mon_syshist_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_syscall_t call,
+			       s3k_syshist_t *hist, bool reset)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_mon_syshist_read(mon_idx, hart, call, hist, reset);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+s3k_err_t s3k_try_mon_acct_read(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_acct_t *acct)
+{
+	sys_args_t args = {.mon_acct = {mon_idx, pid, acct}};
+	return do_ecall(S3K_SYS_MON_ACCT_READ, args).err;
+}
+
+s3k_err_t s3k_mon_acct_read(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_acct_t *acct)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_mon_acct_read(mon_idx, pid, acct);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+s3k_err_t s3k_try_mon_trace_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_trace_rec_t *buf,
+				 uint64_t n, uint64_t *cnt)
+{
+	sys_args_t args = {.mon_trace = {mon_idx, hart, buf, n}};
+	s3k_ret_t ret = do_ecall(S3K_SYS_MON_TRACE_READ, args);
+	if (!ret.err)
+		*cnt = ret.val;
+	return ret.err;
+}
+
+s3k_err_t s3k_mon_trace_read(s3k_cidx_t mon_idx, s3k_hart_t hart, s3k_trace_rec_t *buf,
+			     uint64_t n, uint64_t *cnt)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_mon_trace_read(mon_idx, hart, buf, n, cnt);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+static s3k_op_t mk_op(s3k_syscall_t call, sys_args_t args)
+{
+	return (s3k_op_t){
+	    call, {args.a0, args.a1, args.a2, args.a3, args.a4, args.a5, args.a6, args.a7}
+	};
+}
+
+s3k_op_t s3k_op_cap_move(s3k_cidx_t src, s3k_cidx_t dst)
+{
+	sys_args_t args = {
+	    .cap = {src, dst}
+	     };
+	return mk_op(S3K_SYS_CAP_MOVE, args);
+}
+
+s3k_op_t s3k_op_cap_delete(s3k_cidx_t idx)
+{
+	sys_args_t args = {.cap = {idx}};
+	return mk_op(S3K_SYS_CAP_DELETE, args);
+}
+
+s3k_op_t s3k_op_cap_revoke(s3k_cidx_t idx)
+{
+	sys_args_t args = {.cap = {idx}};
+	return mk_op(S3K_SYS_CAP_REVOKE, args);
+}
+
+s3k_op_t s3k_op_cap_derive(s3k_cidx_t src, s3k_cidx_t dst, s3k_cap_t ncap)
+{
+	sys_args_t args = {
+	    .cap = {src, dst, ncap}
+	   };
+	return mk_op(S3K_SYS_CAP_DERIVE, args);
+}
+
+s3k_op_t s3k_op_pmp_load(s3k_cidx_t idx, s3k_pmp_slot_t slot)
+{
+	sys_args_t args = {
+	    .pmp = {idx, slot}
+	      };
+	return mk_op(S3K_SYS_PMP_LOAD, args);
+}
+
+s3k_op_t s3k_op_pmp_unload(s3k_cidx_t idx)
+{
+	sys_args_t args = {.pmp = {idx}};
+	return mk_op(S3K_SYS_PMP_UNLOAD, args);
+}
+
+s3k_op_t s3k_op_mon_suspend(s3k_cidx_t mon, s3k_pid_t pid)
+{
+	sys_args_t args = {
+	    .mon_state = {mon, pid}
+	   };
+	return mk_op(S3K_SYS_MON_SUSPEND, args);
+}
+
+s3k_op_t s3k_op_mon_resume(s3k_cidx_t mon, s3k_pid_t pid)
+{
+	sys_args_t args = {
+	    .mon_state = {mon, pid}
+	   };
+	return mk_op(S3K_SYS_MON_RESUME, args);
+}
+
+s3k_op_t s3k_op_mon_reg_write(s3k_cidx_t mon, s3k_pid_t pid, s3k_reg_t reg, uint64_t val)
+{
+	sys_args_t args = {
+	    .mon_reg = {mon, pid, reg, val}
+	   };
+	return mk_op(S3K_SYS_MON_REG_WRITE, args);
+}
+
+s3k_op_t s3k_op_mon_cap_move(s3k_cidx_t mon_idx, s3k_pid_t src_pid, s3k_cidx_t src_idx,
+			     s3k_pid_t dst_pid, s3k_cidx_t dst_idx)
+{
+	sys_args_t args = {
+	    .mon_cap = {mon_idx, src_pid, src_idx, dst_pid, dst_idx}
+	   };
+	return mk_op(S3K_SYS_MON_CAP_MOVE, args);
+}
+
+s3k_op_t s3k_op_mon_pmp_load(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx,
+			     s3k_pmp_slot_t pmp_slot)
+{
+	sys_args_t args = {
+	    .mon_pmp = {mon_idx, pid, pmp_idx, pmp_slot}
+	   };
+	return mk_op(S3K_SYS_MON_PMP_LOAD, args);
+}
+
+s3k_op_t s3k_op_mon_pmp_unload(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t pmp_idx)
+{
+	sys_args_t args = {
+	    .mon_pmp = {mon_idx, pid, pmp_idx}
+	   };
+	return mk_op(S3K_SYS_MON_PMP_UNLOAD, args);
+}
+
+s3k_err_t s3k_try_multicall(const s3k_op_t *ops, uint64_t n, uint64_t *done)
+{
+	sys_args_t args = {
+	    .multicall = {ops, n}
+	   };
+	s3k_ret_t ret = do_ecall(S3K_SYS_MULTICALL, args);
+	*done = ret.val;
+	return ret.err;
+}
+
+s3k_err_t s3k_multicall(const s3k_op_t *ops, uint64_t n, uint64_t *done)
+{
+	s3k_err_t err;
+	uint64_t cnt;
+	*done = 0;
+	do {
+		// Resume after the operations completed before preemption.
+		err = s3k_try_multicall(ops + *done, n - *done, &cnt);
+		*done += cnt;
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+s3k_err_t s3k_cap_read_range(s3k_cidx_t idx, s3k_cap_t *buf, uint64_t n)
+{
+#ifdef S3K_CAP_MIRROR
+	if (cap_mirror) {
+		if (idx >= S3K_CAP_CNT || n > (uint64_t)S3K_CAP_CNT - idx)
+			return S3K_ERR_INVALID_INDEX;
+		cap_mirror_read(idx, buf, n);
+		return S3K_SUCCESS;
+	}
+#endif
+	sys_args_t args = {
+	    .cap_range = {idx, buf, n}
+	   };
+	return do_ecall(S3K_SYS_CAP_READ_RANGE, args).err;
+}
+
+s3k_err_t s3k_mon_cap_read_range(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t idx,
+				 s3k_cap_t *buf, uint64_t n)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_mon_cap_read_range(mon_idx, pid, idx, buf, n);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+s3k_err_t s3k_try_mon_cap_read_range(s3k_cidx_t mon_idx, s3k_pid_t pid, s3k_cidx_t idx,
+				     s3k_cap_t *buf, uint64_t n)
+{
+	sys_args_t args = {
+	    .mon_cap_range = {mon_idx, pid, idx, buf, n}
+	   };
+	return do_ecall(S3K_SYS_MON_CAP_READ_RANGE, args).err;
+}
+
+s3k_err_t s3k_cap_find(s3k_cidx_t idx, s3k_capty_t type, uint64_t mask, uint64_t val,
+		       s3k_cidx_t *found)
+{
+	sys_args_t args = {
+	    .cap_find = {idx, type, mask, val}
+	   };
+	s3k_ret_t ret = do_ecall(S3K_SYS_CAP_FIND, args);
+	if (!ret.err)
+		*found = ret.val;
+	return ret.err;
+}
+
+s3k_err_t s3k_cap_find_free(s3k_cidx_t idx, s3k_cidx_t *found)
+{
+	return s3k_cap_find(idx, S3K_CAPTY_NONE, 0, 0, found);
+}
+
+s3k_err_t s3k_try_cap_parent(s3k_cidx_t idx, s3k_cidx_t *parent)
+{
+	sys_args_t args = {.cap = {idx}};
+	s3k_ret_t ret = do_ecall(S3K_SYS_CAP_PARENT, args);
+	if (!ret.err)
+		*parent = ret.val;
+	return ret.err;
+}
+
+s3k_err_t s3k_cap_parent(s3k_cidx_t idx, s3k_cidx_t *parent)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_cap_parent(idx, parent);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
+
+s3k_err_t s3k_try_cap_descendants(s3k_cidx_t idx, uint64_t *n)
+{
+	sys_args_t args = {.cap = {idx}};
+	s3k_ret_t ret = do_ecall(S3K_SYS_CAP_DESCENDANTS, args);
+	if (!ret.err)
+		*n = ret.val;
+	return ret.err;
+}
+
+s3k_err_t s3k_cap_descendants(s3k_cidx_t idx, uint64_t *n)
+{
+	s3k_err_t err;
+	do {
+		err = s3k_try_cap_descendants(idx, n);
+	} while (err == S3K_ERR_PREEMPTED);
+	return err;
+}
@@ -0,0 +1,28 @@
+/**
+ * Per-process CPU accounting, in ticks of the real-time clock.
+ *
+ * Only the hart running a process updates its accounts, a read from another
+ * hart may miss the current dispatch.
+ */
+#pragma once
+
+#include "proc.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct acct {
+	uint64_t run;	// Ticks the process held a hart.
+	uint64_t alloc; // Ticks of the slices it was dispatched to.
+	uint64_t sched; // Ticks of its slices spent in the scheduler.
+	uint64_t unused; // Ticks of its slices left after an early yield.
+} acct_t;
+
+/// The scheduler dispatches p at now to a slice running from start to end.
+void acct_dispatch(proc_t *p, uint64_t now, uint64_t start, uint64_t end);
+/// Process p is about to run on this hart.
+void acct_enter(proc_t *p);
+/// Process p leaves the hart. If yield, the rest of the slice is unused.
+void acct_release(proc_t *p, bool yield);
+/// Copy the accounts of process pid.
+void acct_read(pid_t pid, acct_t *acct);
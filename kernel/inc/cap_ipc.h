@@ -10,9 +10,20 @@ typedef struct ipc_msg {
 	cte_t src_buf;
 	bool send_cap;
 	uint64_t data[4];
+	// Receiver whose capability buffer is locked, if send_cap.
+	proc_t *recv;
 } ipc_msg_t;
 
 err_t cap_sock_send(cte_t sock, const ipc_msg_t *msg, proc_t **next);
 err_t cap_sock_recv(cte_t sock);
 err_t cap_sock_sendrecv(cte_t sock, const ipc_msg_t *msg, proc_t **next);
+/**
+ * Get the process waiting for a message on the other end of a socket.
+ *
+ * Read without the channel lock, so the receiver may change before sending.
+ *
+ * @param sock_cap The socket capability.
+ * @return The waiting process, or NULL if none or not a socket.
+ */
+proc_t *cap_sock_peer(cap_t sock_cap);
 void cap_sock_clear(cap_t cap, proc_t *p);
@@ -0,0 +1,35 @@
+/**
+ * Read-only mirrors of the capability tables, kept if S3K_CAP_MIRROR is
+ * defined.
+ *
+ * The kernel copies every capability it writes to the mirror of the owning
+ * process. The boot process gets read access to all mirrors as a memory
+ * capability after INIT_CAPS, and hands each process a PMP capability of its
+ * own mirror, at offset pid * CAP_MIRROR_SIZE. A process then reads its
+ * capabilities with plain loads. The generation is odd while the kernel
+ * updates the mirror, readers retry if it is odd or changed during the read.
+ */
+#pragma once
+
+#include "cap_types.h"
+
+#include <stdint.h>
+
+typedef struct {
+	uint64_t gen; // Twice the number of updates, odd during an update.
+	cap_t caps[S3K_CAP_CNT];
+} cap_mirror_t;
+
+// Size of a mirror, rounded up to a power of two for a PMP region.
+#define CAP_MIRROR_SIZE (1ull << (64 - __builtin_clzll(sizeof(cap_mirror_t) - 1)))
+
+#ifdef S3K_CAP_MIRROR
+/// Copy the capability of entry idx of pid to its mirror.
+void cap_mirror_set(uint64_t pid, uint64_t idx, cap_t cap);
+/// Read-only memory capability of the mirrors, for the boot process.
+cap_t cap_mirror_cap(void);
+#else
+static inline void cap_mirror_set(uint64_t pid, uint64_t idx, cap_t cap)
+{
+}
+#endif
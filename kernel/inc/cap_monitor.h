@@ -40,6 +40,9 @@
 #include "cap_table.h"
 #include "error.h"
 #include "proc.h"
+#include "syshist.h"
+#include "acct.h"
+#include "trace.h"
 
 /**
  * Suspends a specified process.
@@ -131,6 +134,21 @@ err_t cap_monitor_reg_write(cte_t mon, pid_t pid, reg_t reg, uint64_t val);
  */
 err_t cap_monitor_cap_read(cte_t mon, cte_t src, cap_t *cap);
 
+/**
+ * Reads the capabilities of n consecutive CTEs of a suspended process.
+ *
+ * @param mon The CTE of the monitor capability.
+ * @param pid The ID of the process.
+ * @param idx The index of the first CTE.
+ * @param n The number of CTEs.
+ * @param buf Where to copy the capabilities, empty CTEs read as zero.
+ * @return SUCCESS if the capabilities are read.
+ *         ERR_INVALID_INDEX if the range ends past the table.
+ *         ERR_INVALID_MONITOR if unauthorized or wrong capability type.
+ *         ERR_INVALID_STATE if the process is not suspended.
+ */
+err_t cap_monitor_cap_read_range(cte_t mon, pid_t pid, cidx_t idx, uint64_t n, cap_t *buf);
+
 /**
  * Moves a capability from a source to a destination CTE of a suspended process.
  *
@@ -187,3 +205,95 @@ err_t cap_monitor_pmp_unload(cte_t mon, cte_t pmp);
  *         ERR_PATH_TOO_LONG if the buf cannot fit the path
  */
 err_t cap_monitor_path_read(cte_t mon, cte_t path, char *buf, size_t n);
+
+/**
+ * Sets or clears the slack process of a hart.
+ *
+ * The slack process runs in slots of time capabilities with the slack flag
+ * whose owner cannot run. Replacing a slack process requires that the monitor
+ * also covers the current one.
+ *
+ * @param mon The CTE of the monitor capability.
+ * @param pid The ID of the slack process.
+ * @param hart The hart to set the slack process of.
+ * @param enable Set pid as slack process if true, clear it if false.
+ * @return SUCCESS if the slack process was set or cleared.
+ *         ERR_EMPTY if the CTE is empty.
+ *         ERR_INVALID_MONITOR if unauthorized or wrong capability type.
+ *         ERR_INVALID_STATE if clearing and pid is not the slack process.
+ */
+err_t cap_monitor_slack_set(cte_t mon, pid_t pid, hart_t hart, bool enable);
+
+/**
+ * Reads the system call latency histogram of a hart.
+ *
+ * The histograms cover all processes, so the monitor must cover all
+ * processes.
+ *
+ * @param mon The CTE of the monitor capability.
+ * @param hart The hart of the histogram.
+ * @param call The system call of the histogram.
+ * @param hist Where to copy the histogram.
+ * @param reset Reset the histogram after reading it if true.
+ * @return SUCCESS if the histogram was read.
+ *         ERR_INVALID_MONITOR if unauthorized or wrong capability type.
+ */
+err_t cap_monitor_syshist_read(cte_t mon, hart_t hart, uint64_t call,
+			       syshist_t *hist, bool reset);
+
+/**
+ * Reads the CPU accounts of a process.
+ *
+ * @param mon The CTE of the monitor capability.
+ * @param pid The ID of the process.
+ * @param acct Where to copy the accounts.
+ * @return SUCCESS if the accounts were read.
+ *         ERR_INVALID_MONITOR if unauthorized or wrong capability type.
+ */
+err_t cap_monitor_acct_read(cte_t mon, pid_t pid, acct_t *acct);
+
+/**
+ * Drains the event trace of a hart, see trace.h.
+ *
+ * The trace covers all processes, so the monitor must cover all processes.
+ *
+ * @param mon The CTE of the monitor capability.
+ * @param hart The hart of the trace.
+ * @param buf Where to copy the records, oldest first.
+ * @param n The capacity of buf in records.
+ * @param cnt Set to the number of records copied.
+ * @return SUCCESS if the trace was read.
+ *         ERR_INVALID_MONITOR if unauthorized or wrong capability type.
+ */
+err_t cap_monitor_trace_read(cte_t mon, hart_t hart, trace_rec_t *buf,
+			     uint64_t n, uint64_t *cnt);
+
+/**
+ * Reads the longest system call of all harts and resets it, see syshist.h.
+ *
+ * The maximum covers all processes, so the monitor must cover all
+ * processes.
+ *
+ * @param mon The CTE of the monitor capability.
+ * @param wcet Set to the maximum before the reset.
+ * @return SUCCESS if the maximum was read and reset.
+ *         ERR_INVALID_MONITOR if unauthorized or wrong capability type.
+ */
+err_t cap_monitor_wcet_reset(cte_t mon, uint64_t *wcet);
+
+/**
+ * Reads a lock statistic of a hart and resets it, see lockstat.h.
+ *
+ * The statistics cover all processes, so the monitor must cover all
+ * processes.
+ *
+ * @param mon The CTE of the monitor capability.
+ * @param hart The hart of the statistic.
+ * @param lock The lock of the statistic.
+ * @param stat The statistic.
+ * @param val Set to the statistic before the reset.
+ * @return SUCCESS if the statistic was read and reset.
+ *         ERR_INVALID_MONITOR if unauthorized or wrong capability type.
+ */
+err_t cap_monitor_lockstat_reset(cte_t mon, hart_t hart, uint64_t lock,
+				 uint64_t stat, uint64_t *val);
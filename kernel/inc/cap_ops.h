@@ -4,8 +4,12 @@
 #include "error.h"
 
 err_t cap_read(cte_t cte, cap_t *cap);
+err_t cap_read_range(pid_t pid, cidx_t idx, uint64_t n, cap_t *buf);
 err_t cap_move(cte_t src, cte_t dst, cap_t *cap);
 err_t cap_delete(cte_t cte);
 void cap_reclaim(cte_t parent, cap_t parent_cap, cte_t child, cap_t child_cap);
+void cap_reclaim_sched(cte_t parent, time_slot_t from);
 err_t cap_reset(cte_t cte);
 err_t cap_derive(cte_t src, cte_t dst, cap_t new_cap);
+err_t cap_time_stage(cte_t cte);
+err_t cap_time_commit(cte_t cte, time_slot_t slot);
@@ -9,6 +9,13 @@
 
 typedef struct cte *cte_t;
 
+// Capability table entry, only accessed through the functions below. The
+// layout is visible for offsets.c.
+struct cte {
+	uint32_t prev, next;
+	cap_t cap;
+};
+
 void ctable_init(void);
 cte_t ctable_get(uint64_t pid, uint64_t index);
 bool cte_is_empty(cte_t c);
@@ -19,6 +26,24 @@ cte_t cte_next(cte_t c);
 cte_t cte_prev(cte_t c);
 cap_t cte_cap(cte_t c);
 pid_t cte_pid(cte_t c);
+cidx_t cte_idx(cte_t c);
+// Derivation tree, NULL for no entry. The first child of c is its next entry
+// in the derivation list, the initial capabilities have no parent. The links
+// of c are stable under the lock of its parent's process, those of its
+// children under the lock of c's process.
+cte_t cte_parent(cte_t c);
+cte_t cte_child(cte_t c);
+cte_t cte_sibling(cte_t c);
+// Number of capabilities derived from c, directly or not, and sets
+// owners[pid] for the processes holding them. Exact under the locks of c's
+// process and of the owners, bounded but inexact without them.
+uint64_t cte_descendants(cte_t c, bool owners[]);
 void cte_move(cte_t src, cte_t dst, cap_t *cap);
 cap_t cte_delete(cte_t c);
-void cte_insert(cte_t c, cap_t cap, cte_t prev);
+// Insert c as the first child of parent.
+void cte_insert(cte_t c, cap_t cap, cte_t parent);
+
+// Index of the first entry of pid from idx on holding a capability of the
+// type whose bits under mask equal val, S3K_CAP_CNT if none. CAPTY_NONE
+// finds empty entries.
+uint64_t ctable_find(uint64_t pid, uint64_t idx, capty_t type, uint64_t mask, uint64_t val);
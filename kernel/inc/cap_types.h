@@ -82,7 +82,9 @@ typedef union cap {
 
 	struct {
 		capty_t type : 4;
-		uint16_t _padding : 4;
+		// Lend unused time to the hart's slack process.
+		uint16_t slack : 1;
+		uint16_t _padding : 3;
 		hart_t hart;
 		time_slot_t bgn;
 		time_slot_t mrk;
@@ -10,5 +10,6 @@ cap_t cap_mk_socket(chan_t chan, ipc_mode_t mode, ipc_perm_t perm, uint32_t tag)
 cap_t cap_mk_path(uint32_t tag, path_flags_t flags);
 
 bool cap_is_valid(cap_t cap);
+// False for paths, their derivations are known only from the derivation tree.
 bool cap_is_revokable(cap_t parent, cap_t child);
 bool cap_is_derivable(cap_t parent, cap_t child);
@@ -13,18 +13,33 @@
 #define MIE_MTIE 0x80
 #define MCAUSE_USER_ECALL 0x8
 #define MSTATUS_MIE 0x8
+#define MTVEC_VECTORED 0x1
+#define MSTATUS_FS 0x6000
+#define MSTATUS_FS_OFF 0x0
+#define MSTATUS_FS_CLEAN 0x4000
+#define MSTATUS_FS_DIRTY 0x6000
 
 #ifndef __ASSEMBLER__
 #include <stdint.h>
 uint64_t csrr_mhartid(void);
 uint64_t csrr_mip(void);
 uint64_t csrr_mcycle(void);
+uint64_t csrr_minstret(void);
 uint64_t csrr_mhpmcounter3(void);
+uint64_t csrr_mhpmcounter4(void);
+uint64_t csrr_mhpmcounter5(void);
+uint64_t csrr_mhpmcounter6(void);
 void csrw_mcycle(uint64_t val);
 void csrw_mhpmcounter3(uint64_t val);
+void csrw_mhpmevent3(uint64_t val);
+void csrw_mhpmevent4(uint64_t val);
+void csrw_mhpmevent5(uint64_t val);
+void csrw_mhpmevent6(uint64_t val);
 void csrw_mstatus(uint64_t val);
 void csrs_mstatus(uint64_t val);
 void csrc_mstatus(uint64_t val);
+void csrs_mie(uint64_t val);
+void csrc_mie(uint64_t val);
 uint64_t csrr_pmpcfg0(void);
 uint64_t csrr_pmpaddr0(void);
 uint64_t csrr_pmpaddr1(void);
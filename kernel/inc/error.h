@@ -32,4 +32,8 @@ typedef enum {
 	ERR_PATH_EXISTS,
 	ERR_PATH_STAT,
 
+	ERR_INVALID_HART,
+	ERR_INVALID_TIME,
+	ERR_NOT_FOUND,
+
 } err_t;
@@ -0,0 +1,59 @@
+#pragma once
+/**
+ * @file fpu.h
+ * @brief Lazy floating-point context switching, enabled by S3K_FPU.
+ *
+ * A process runs with mstatus.FS off unless the hart's floating-point
+ * registers already hold its context. Its first floating-point instruction
+ * then traps and fpu_trap() loads the context. A dirty context stays in the
+ * registers when its process leaves the hart, it is saved when another
+ * process takes the trap on that hart. If the process is dispatched on
+ * another hart, a software interrupt asks the hart holding the context to
+ * save it, and its fpu_trap() there waits for the save. Processes that do not
+ * use floating point never have their context saved or loaded.
+ */
+#include "proc.h"
+
+#include <stdbool.h>
+
+#ifdef S3K_FPU
+/// Process p leaves the hart, note if its context in the registers is dirty.
+void fpu_release(proc_t *p);
+/// Process p is dispatched on this hart, if its context is dirty on another
+/// hart ask that hart to save it.
+void fpu_dispatch(proc_t *p);
+/// Process p is about to run on this hart, set the mstatus.FS it runs with.
+void fpu_enter(proc_t *p);
+/// Illegal instruction by p, load its context if it ran with mstatus.FS off.
+/// Returns true if the instruction should be retried.
+bool fpu_trap(proc_t *p);
+/// Serve a request of another hart to save the context in our registers.
+void fpu_sync(void);
+/// Software interrupt while p runs or is about to, serve the request and
+/// resume p.
+void fpu_ipi(proc_t *p) __attribute__((noreturn));
+
+void fpu_save(fpu_t *fpu);
+void fpu_restore(const fpu_t *fpu);
+#else
+static inline void fpu_release(proc_t *p)
+{
+}
+
+static inline void fpu_dispatch(proc_t *p)
+{
+}
+
+static inline void fpu_enter(proc_t *p)
+{
+}
+
+static inline bool fpu_trap(proc_t *p)
+{
+	return false;
+}
+
+static inline void fpu_sync(void)
+{
+}
+#endif
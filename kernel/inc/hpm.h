@@ -0,0 +1,54 @@
+#pragma once
+/**
+ * @file hpm.h
+ * @brief Per-process performance counters, enabled by S3K_HPM_CNT.
+ *
+ * The registers REG_CYCLE, REG_INSTRET and the first S3K_HPM_CNT (at most 4)
+ * of REG_HPMCOUNTER3-6 count only while the process holds a hart. The
+ * hardware counters are never written: when the process gets a hart the
+ * counters are sampled, when it leaves the difference is added to its
+ * registers. REG_HPMEVENT3-6 select the events, they are written to
+ * mhpmevent3-6 when the process gets a hart, masked by S3K_HPM_EVENT_MASK.
+ * Counting includes the kernel's work on behalf of the process, e.g., its
+ * system calls. User mode cannot read the hardware counters directly, they
+ * count for all processes on the hart.
+ */
+#include "proc.h"
+
+#include <stdbool.h>
+
+#ifdef S3K_HPM_CNT
+_Static_assert(S3K_HPM_CNT <= 4, "S3K_HPM_CNT at most 4");
+
+// Event bits a process may select, by default all but the Sscofpmf overflow
+// and mode-inhibit bits (63-56), so a process cannot hide the kernel's work
+// from its counts or raise overflow interrupts.
+#ifndef S3K_HPM_EVENT_MASK
+#define S3K_HPM_EVENT_MASK ((1ull << 56) - 1)
+#endif
+
+/// Process p is about to run on this hart, program its events and sample.
+void hpm_enter(proc_t *p);
+/// Process p leaves the hart, add the counts since hpm_enter().
+void hpm_release(proc_t *p);
+/// Bring the counters of the running process p up to date, and program its
+/// events again, before its counter or event registers are accessed.
+void hpm_sync(proc_t *p);
+#else
+static inline void hpm_enter(proc_t *p)
+{
+}
+
+static inline void hpm_release(proc_t *p)
+{
+}
+
+static inline void hpm_sync(proc_t *p)
+{
+}
+#endif
+
+static inline bool hpm_is_reg(reg_t reg)
+{
+	return REG_CYCLE <= reg && reg <= REG_HPMEVENT6;
+}
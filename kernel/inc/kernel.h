@@ -1,16 +1,42 @@
 #pragma once
 
+#include "cap_table.h"
+#include "mcslock.h"
 #include "proc.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 
 void kernel_init(void);
-uint64_t kernel_wcet(void);
-void kernel_wcet_reset(void);
 
-bool kernel_lock(proc_t *p);
-void kernel_unlock(proc_t *p);
+// Most capability table entries locked by kernel_lock_ctes().
+#define KERNEL_CTE_MAX 4
+
+/**
+ * Kernel locks.
+ *
+ * Each process has a lock protecting its capability table entries and its
+ * process state while suspended. Process locks are taken together, in
+ * ascending pid order, and may be followed by the file system lock. Leaf
+ * locks, such as the IPC channel and path locks, are taken last and
+ * released before taking any other lock.
+ *
+ * The lock functions return false on preemption, with all locks of the hart
+ * released.
+ */
 
-void kernel_hook_sys_entry(proc_t *p);
-void kernel_hook_sys_exit(proc_t *p);
+/// Lock the processes pids[0..n), sorts pids.
+bool kernel_lock_procs(proc_t *p, uint64_t n, uint64_t pids[]);
+/// Lock the processes of ctes[0..n), of their neighbours in the derivation
+/// list and of their parents, n <= KERNEL_CTE_MAX.
+bool kernel_lock_ctes(proc_t *p, uint64_t n, const cte_t ctes[]);
+/// True if the hart holds the lock of process pid.
+bool kernel_holds_proc(uint64_t pid);
+/// Lock the file system, after any process locks.
+bool kernel_lock_fs(proc_t *p);
+/// Lock a leaf lock, waits without preemption.
+void kernel_lock_leaf(mcslock_t *lock);
+/// Unlock the last taken lock, which must be a leaf lock.
+void kernel_unlock_leaf(mcslock_t *lock);
+/// Unlock all locks held by the hart.
+void kernel_unlock(proc_t *p);
@@ -0,0 +1,51 @@
+/**
+ * Per-hart lock statistics, collected if INSTRUMENT is defined.
+ *
+ * Times are in cycles. Without INSTRUMENT the functions do nothing and all
+ * statistics read as 0.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+	LOCKSTAT_MCS,	// Kernel MCS locks.
+	LOCKSTAT_SCHED, // Scheduler table writers.
+	LOCKSTAT_LOCK_CNT,
+} lockstat_lock_t;
+
+typedef enum {
+	LOCKSTAT_ACQUIRED, // Successful acquisitions.
+	LOCKSTAT_FAILED,   // Attempts given up on preemption.
+	LOCKSTAT_SPIN,	   // Cycles spent waiting, failed attempts included.
+	LOCKSTAT_HOLD_MAX, // Longest time the lock was held.
+	LOCKSTAT_STAT_CNT,
+} lockstat_stat_t;
+
+#ifdef INSTRUMENT
+/// Current cycle count, for the start of a wait or hold.
+uint64_t lockstat_now(void);
+/// Record an attempt started at start, acquired or not.
+void lockstat_attempt(lockstat_lock_t lock, uint64_t start, bool acquired);
+/// Record a release of a lock acquired at start.
+void lockstat_release(lockstat_lock_t lock, uint64_t start);
+#else
+static inline uint64_t lockstat_now(void)
+{
+	return 0;
+}
+
+static inline void lockstat_attempt(lockstat_lock_t lock, uint64_t start,
+				    bool acquired)
+{
+}
+
+static inline void lockstat_release(lockstat_lock_t lock, uint64_t start)
+{
+}
+#endif
+
+/// Read a statistic of hartid, optionally resetting it.
+uint64_t lockstat_get(uint64_t hartid, uint64_t lock, uint64_t stat,
+		      bool reset);
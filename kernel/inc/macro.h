@@ -21,3 +21,6 @@
 
 /* Returns the size of an array */
 #define ARRAY_SIZE(x) (sizeof(x) / (sizeof((x)[0])))
+
+/* Size of a cache line, for keeping data of different harts apart */
+#define CACHE_LINE 64
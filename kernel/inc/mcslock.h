@@ -1,19 +1,36 @@
 #pragma once
 
+#include "macro.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 
+typedef enum {
+	QNODE_FREE,	 // Not in any queue, can be reused.
+	QNODE_WAITING,	 // Queued, waiting for the predecessor.
+	QNODE_GRANTED,	 // Holds the lock.
+	QNODE_ABANDONED, // Gave up waiting, freed by a later releaser.
+} qnode_state_t;
+
+// Queue nodes and locks are cache line aligned, so waiters spin on lines no
+// other hart writes to.
 typedef struct qnode {
 	struct qnode *next;
-	struct qnode *prev;
 	uint64_t state;
-} qnode_t;
+	// When the lock was acquired, for lock statistics.
+	uint64_t stamp;
+} __attribute__((aligned(CACHE_LINE))) qnode_t;
 
 typedef struct mcslock {
-	struct qnode tail;
-} mcslock_t;
+	struct qnode *tail;
+} __attribute__((aligned(CACHE_LINE))) mcslock_t;
 
 void mcslock_init(mcslock_t *lock);
+// Check if a node can be used for a new acquire. A node abandoned by
+// mcslock_try_acquire() stays in the queue until the lock is passed it.
+bool qnode_is_free(const qnode_t *qnode);
+// Acquire the lock, gives up if preempted. On failure the node stays owned
+// by the lock until it is freed.
 bool mcslock_try_acquire(mcslock_t *lock, qnode_t *qnode);
 void mcslock_acquire(mcslock_t *lock, qnode_t *qnode);
 void mcslock_release(mcslock_t *lock, qnode_t *qnode);
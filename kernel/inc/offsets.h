@@ -1,53 +0,0 @@
-#pragma once
-
-#define _OFFSET(x) (x * 8)
-
-/* Register offsets */
-#define PROC_PC _OFFSET(0)
-#define PROC_RA _OFFSET(1)
-#define PROC_SP _OFFSET(2)
-#define PROC_GP _OFFSET(3)
-#define PROC_TP _OFFSET(4)
-#define PROC_T0 _OFFSET(5)
-#define PROC_T1 _OFFSET(6)
-#define PROC_T2 _OFFSET(7)
-#define PROC_S0 _OFFSET(8)
-#define PROC_S1 _OFFSET(9)
-#define PROC_A0 _OFFSET(10)
-#define PROC_A1 _OFFSET(11)
-#define PROC_A2 _OFFSET(12)
-#define PROC_A3 _OFFSET(13)
-#define PROC_A4 _OFFSET(14)
-#define PROC_A5 _OFFSET(15)
-#define PROC_A6 _OFFSET(16)
-#define PROC_A7 _OFFSET(17)
-#define PROC_S2 _OFFSET(18)
-#define PROC_S3 _OFFSET(19)
-#define PROC_S4 _OFFSET(20)
-#define PROC_S5 _OFFSET(21)
-#define PROC_S6 _OFFSET(22)
-#define PROC_S7 _OFFSET(23)
-#define PROC_S8 _OFFSET(24)
-#define PROC_S9 _OFFSET(25)
-#define PROC_S10 _OFFSET(26)
-#define PROC_S11 _OFFSET(27)
-#define PROC_T3 _OFFSET(28)
-#define PROC_T4 _OFFSET(29)
-#define PROC_T5 _OFFSET(30)
-#define PROC_T6 _OFFSET(31)
-#define PROC_TPC _OFFSET(32)
-#define PROC_TSP _OFFSET(33)
-#define PROC_EPC _OFFSET(34)
-#define PROC_ESP _OFFSET(35)
-#define PROC_ECAUSE _OFFSET(36)
-#define PROC_EVAL _OFFSET(37)
-#define PROC_SERVTIME _OFFSET(38)
-#define PROC_PMPCFG0 _OFFSET(39)
-#define PROC_PMPADDR0 _OFFSET(40)
-#define PROC_PMPADDR1 _OFFSET(41)
-#define PROC_PMPADDR2 _OFFSET(42)
-#define PROC_PMPADDR3 _OFFSET(43)
-#define PROC_PMPADDR4 _OFFSET(44)
-#define PROC_PMPADDR5 _OFFSET(45)
-#define PROC_PMPADDR6 _OFFSET(46)
-#define PROC_PMPADDR7 _OFFSET(47)
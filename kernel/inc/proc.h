@@ -12,7 +12,7 @@
 
 #include "cap_table.h"
 #include "cap_types.h"
-#include "mcslock.h"
+#include "macro.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -70,14 +70,48 @@ typedef enum {
 	REG_ECAUSE,
 	REG_EVAL,
 	REG_SERVTIME,
+	/* Performance counters of the process, see hpm.h */
+	REG_CYCLE,
+	REG_INSTRET,
+	REG_HPMCOUNTER3,
+	REG_HPMCOUNTER4,
+	REG_HPMCOUNTER5,
+	REG_HPMCOUNTER6,
+	REG_HPMEVENT3,
+	REG_HPMEVENT4,
+	REG_HPMEVENT5,
+	REG_HPMEVENT6,
 	/* Special value for number of registers */
 	REG_CNT,
 } reg_t;
 
+#ifdef S3K_FPU
+/**
+ * @brief Floating-point context of a process, see fpu.h.
+ */
+typedef struct {
+	/** Saved f0-f31 and fcsr. */
+	uint64_t f[32];
+	uint64_t fcsr;
+	/** mstatus.FS of the process, captured on trap entry. */
+	uint64_t fs;
+	/** Hart whose registers last held the context. */
+	uint64_t hart;
+	/** Set if the registers of hart hold a newer context than f. */
+	bool dirty;
+} fpu_t;
+#endif
+
 /**
  * @brief Process control block.
  *
  * Contains all information needed manage a process except the capabilities.
+ *
+ * Laid out in cache lines: the RISC-V registers saved on each trap fill the
+ * first lines, followed by the rarely used virtual registers and PMP
+ * configuration. The fields other harts read and CAS when acquiring the
+ * process are on a line of their own, so they do not false-share with the
+ * registers of this or the next process.
  */
 typedef struct {
 	/** The registers of the process (RISC-V registers and virtual
@@ -86,14 +120,17 @@ typedef struct {
 	/** PMP registers */
 	uint8_t pmpcfg[S3K_PMP_CNT];
 	uint64_t pmpaddr[S3K_PMP_CNT];
-	/** Instrumentation registers */
 	/** Process ID. */
 	pid_t pid;
-	/** Process state. */
-	proc_state_t state;
-	qnode_t qnode;
+	/** Bumped on changes to the PMP registers, see trap_exit. */
+	uint64_t pmp_gen;
+#ifdef S3K_FPU
+	/** Floating-point context. */
+	fpu_t fpu;
+#endif
 
-	/** Scheduling information */
+	/** Process state. */
+	proc_state_t state __attribute__((aligned(CACHE_LINE)));
 
 	/***** IPC related things *****/
 	/**
@@ -111,7 +148,18 @@ typedef struct {
 	 * Source and destination pointer for transmitting capabilities.
 	 */
 	cte_t cap_buf;
-} proc_t;
+} __attribute__((aligned(CACHE_LINE))) proc_t;
+
+/**
+ * @brief PMP configuration installed in a hart's CSRs.
+ *
+ * Kept by trap_exit, which skips the CSR writes if the process and its PMP
+ * generation are unchanged. One cache line per hart.
+ */
+typedef struct {
+	proc_t *proc;
+	uint64_t pmp_gen;
+} __attribute__((aligned(CACHE_LINE))) pmp_installed_t;
 
 /**
  * Initializes all processes in the system.
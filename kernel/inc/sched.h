@@ -8,12 +8,17 @@
  * a temporary fix in sched_next.
  */
 
+#include "error.h"
 #include "macro.h"
 #include "proc.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+// No slack process on the hart.
+#define SCHED_NO_SLACK UINT64_MAX
+
 /**
  * @brief Initialize the scheduler.
  *
@@ -31,9 +36,39 @@ void sched_init(void);
  */
 void sched(proc_t *) NORETURN;
 
-/// Let pid run on hartid, begin-end.
+/// Let pid run on hartid, begin-end. If slack is set, time pid cannot use
+/// is lent to the slack process of hartid.
 void sched_update(uint64_t pid, uint64_t end, uint64_t hartid, uint64_t from,
-		  uint64_t to);
+		  uint64_t to, bool slack);
+
+/// Like sched_update(), but also changes staged slots in the live table. For
+/// time given back by revocation.
+void sched_reclaim(uint64_t pid, uint64_t end, uint64_t hartid, uint64_t from,
+		   uint64_t to, bool slack);
 
-/// Delete scheduling at hartid, begin-end.
+/// Delete scheduling at hartid, begin-end, staged or not.
 void sched_delete(uint64_t hartid, uint64_t from, uint64_t to);
+
+/// Stage slots from-to of hartid for owner, later updates to them only go to
+/// the shadow table until committed. One staging per hart.
+err_t sched_stage(uint64_t hartid, const void *owner, uint64_t from,
+		  uint64_t to);
+
+/// If owner staged slots of hartid, publish them now and end the staging.
+void sched_unstage(uint64_t hartid, const void *owner);
+
+/// Make the shadow table of hartid live from the next occurrence of slot. The
+/// staged slots must be within from-to.
+err_t sched_commit(uint64_t hartid, uint64_t from, uint64_t to, uint64_t slot);
+
+/// Slack process of hartid, or SCHED_NO_SLACK.
+uint64_t sched_slack_get(uint64_t hartid);
+
+/// Set the slack process of hartid if it is curr, SCHED_NO_SLACK disables it.
+bool sched_slack_set(uint64_t hartid, uint64_t curr, uint64_t pid);
+
+/// Wake idle harts so they look at the schedule again.
+void sched_kick(void);
+
+/// Time hartid has spent idle, in timer ticks.
+uint64_t sched_idle_time(uint64_t hartid);
@@ -2,53 +2,124 @@
 
 #include "cap_types.h"
 #include "proc.h"
+#include "syshist.h"
+#include "acct.h"
+#include "trace.h"
 
 #include <stdint.h>
 
+/*
+ * The system calls, one X(NAME, name, group, multi, lock, args...) per call,
+ * in the order of their numbers. sys_name is the handler, group the
+ * S3K_SYSCALLS_<group> option compiling the call in or out, multi is MULTI
+ * if SYS_MULTICALL may batch the call and SINGLE otherwise, lock the locks
+ * taken before the handler runs and args the checks of the arguments, in
+ * order. See syscall.c for the lock and argument kinds.
+ */
+#define SYSCALLS(X)                                                                            \
+	/* Basic Info & Registers */                                                           \
+	X(GET_INFO, get_info, CORE, SINGLE, NOLOCK, NOARGS)                                    \
+	X(REG_READ, reg_read, CORE, SINGLE, NOLOCK, ARG(REG, reg.reg))                         \
+	X(REG_WRITE, reg_write, CORE, SINGLE, NOLOCK, ARG(REG, reg.reg))                       \
+	X(SYNC, sync, CORE, SINGLE, NOLOCK, NOARGS)                                            \
+	/* Capability Management */                                                            \
+	X(CAP_READ, cap_read, CORE, SINGLE, NOLOCK, ARG(CIDX, cap.idx))                        \
+	X(CAP_MOVE, cap_move, CORE, MULTI, LOCK_CTES(OWN_CTE(cap.idx), OWN_CTE(cap.dst_idx)),  \
+	  ARG(CIDX, cap.idx), ARG(CIDX, cap.dst_idx))                                          \
+	X(CAP_DELETE, cap_delete, CORE, MULTI, LOCK_CTES(OWN_CTE(cap.idx)), ARG(CIDX, cap.idx)) \
+	X(CAP_REVOKE, cap_revoke, CORE, MULTI, NOLOCK, ARG(CIDX, cap.idx))                     \
+	X(CAP_DERIVE, cap_derive, CORE, MULTI, LOCK_CTES(OWN_CTE(cap.idx), OWN_CTE(cap.dst_idx)), \
+	  ARG(CIDX, cap.idx), ARG(CIDX, cap.dst_idx), ARG(CAP, cap.cap))                       \
+	/* PMP */                                                                              \
+	X(PMP_LOAD, pmp_load, CORE, MULTI, LOCK_CTES(OWN_CTE(pmp.pmp_idx)), ARG(CIDX, pmp.pmp_idx), \
+	  ARG(PMP_SLOT, pmp.pmp_slot))                                                         \
+	X(PMP_UNLOAD, pmp_unload, CORE, MULTI, LOCK_CTES(OWN_CTE(pmp.pmp_idx)),                \
+	  ARG(CIDX, pmp.pmp_idx))                                                              \
+	/* Monitor */                                                                          \
+	X(MON_SUSPEND, mon_suspend, MON, MULTI, LOCK_PROC(mon_state.pid), ARG(CIDX, mon_state.mon_idx), \
+	  ARG(PID, mon_state.pid))                                                             \
+	X(MON_RESUME, mon_resume, MON, MULTI, LOCK_PROC(mon_state.pid), ARG(CIDX, mon_state.mon_idx), \
+	  ARG(PID, mon_state.pid))                                                             \
+	X(MON_STATE_GET, mon_state_get, MON, SINGLE, LOCK_PROC(mon_state.pid),                 \
+	  ARG(CIDX, mon_state.mon_idx), ARG(PID, mon_state.pid))                               \
+	X(MON_YIELD, mon_yield, MON, SINGLE, LOCK_PROC(mon_state.pid), ARG(CIDX, mon_state.mon_idx), \
+	  ARG(PID, mon_state.pid))                                                             \
+	X(MON_REG_READ, mon_reg_read, MON, SINGLE, LOCK_PROC(mon_reg.pid), ARG(CIDX, mon_reg.mon_idx), \
+	  ARG(PID, mon_reg.pid), ARG(REG, mon_reg.reg))                                        \
+	X(MON_REG_WRITE, mon_reg_write, MON, MULTI, LOCK_PROC(mon_reg.pid),                    \
+	  ARG(CIDX, mon_reg.mon_idx), ARG(PID, mon_reg.pid), ARG(REG, mon_reg.reg))            \
+	X(MON_CAP_READ, mon_cap_read, MON, SINGLE, LOCK_PROC(mon_cap.pid), ARG(CIDX, mon_cap.mon_idx), \
+	  ARG(PID, mon_cap.pid), ARG(CIDX, mon_cap.idx))                                       \
+	X(MON_CAP_MOVE, mon_cap_move, MON, MULTI,                                              \
+	  LOCK_CTES(OWN_CTE(mon_cap.mon_idx), CTE(mon_cap.pid, mon_cap.idx),                   \
+		    CTE(mon_cap.dst_pid, mon_cap.dst_idx)),                                    \
+	  ARG(CIDX, mon_cap.mon_idx), ARG(PID, mon_cap.pid), ARG(CIDX, mon_cap.idx),           \
+	  ARG(PID, mon_cap.dst_pid), ARG(CIDX, mon_cap.dst_idx))                               \
+	X(MON_PMP_LOAD, mon_pmp_load, MON, MULTI,                                              \
+	  LOCK_CTES(OWN_CTE(mon_pmp.mon_idx), CTE(mon_pmp.pid, mon_pmp.pmp_idx)),              \
+	  ARG(CIDX, mon_pmp.mon_idx), ARG(PID, mon_pmp.pid), ARG(CIDX, mon_pmp.pmp_idx),       \
+	  ARG(PMP_SLOT, mon_pmp.pmp_slot))                                                     \
+	X(MON_PMP_UNLOAD, mon_pmp_unload, MON, MULTI,                                          \
+	  LOCK_CTES(OWN_CTE(mon_pmp.mon_idx), CTE(mon_pmp.pid, mon_pmp.pmp_idx)),              \
+	  ARG(CIDX, mon_pmp.mon_idx), ARG(PID, mon_pmp.pid), ARG(CIDX, mon_pmp.pmp_idx))       \
+	/* Socket */                                                                           \
+	X(SOCK_SEND, sock_send, IPC, SINGLE, NOLOCK, ARG(CIDX, sock.sock_idx), ARG(CIDX, sock.cap_idx)) \
+	X(SOCK_RECV, sock_recv, IPC, SINGLE, NOLOCK, ARG(CIDX, sock.sock_idx), ARG(CIDX, sock.cap_idx)) \
+	X(SOCK_SENDRECV, sock_sendrecv, IPC, SINGLE, NOLOCK, ARG(CIDX, sock.sock_idx),         \
+	  ARG(CIDX, sock.cap_idx))                                                             \
+	/* Path+file calls, they take the file system lock themselves */                       \
+	X(PATH_READ, path_read, FS, SINGLE, LOCK_SELF, ARG(CIDX, read_path.idx),               \
+	  BUFN(read_path.buf, read_path.n, 1, MEM_RW))                                         \
+	X(MON_PATH_READ, mon_path_read, FS, SINGLE, LOCK_PROC(mon_read_path.pid),              \
+	  ARG(CIDX, mon_read_path.mon_idx), ARG(PID, mon_read_path.pid),                       \
+	  ARG(CIDX, mon_read_path.idx), BUFN(mon_read_path.buf, mon_read_path.n, 1, MEM_RW))   \
+	X(PATH_DERIVE, path_derive, FS, SINGLE, LOCK_CTES(OWN_CTE(path.idx), OWN_CTE(path.dst_idx)), \
+	  ARG(CIDX, path.idx), ARG(CIDX, path.dst_idx), ARG(PATH, path.path))                  \
+	X(READ_FILE, read_file, FS, SINGLE, LOCK_SELF, ARG(CIDX, file.idx),                    \
+	  BUFN(file.buf, file.buf_size, 1, MEM_RW), BUF(file.bytes_result, MEM_RW))            \
+	X(WRITE_FILE, write_file, FS, SINGLE, LOCK_SELF, ARG(CIDX, file.idx),                  \
+	  BUFN(file.buf, file.buf_size, 1, MEM_RW), BUF(file.bytes_result, MEM_RW))            \
+	X(CREATE_DIR, create_dir, FS, SINGLE, LOCK_SELF, ARG(CIDX, create_dir.idx))            \
+	X(PATH_DELETE, path_delete, FS, SINGLE, LOCK_SELF, ARG(CIDX, delete_path.idx))         \
+	X(READ_DIR, read_dir, FS, SINGLE, LOCK_SELF, ARG(CIDX, read_dir.directory),            \
+	  BUF(read_dir.out, MEM_RW))                                                           \
+	/* Scheduling */                                                                       \
+	X(MON_SLACK_SET, mon_slack_set, SCHED, SINGLE, LOCK_PROC(mon_slack.pid),               \
+	  ARG(CIDX, mon_slack.mon_idx), ARG(PID, mon_slack.pid), ARG(HART, mon_slack.hart))    \
+	X(SCHED_STAGE, sched_stage, SCHED, SINGLE, LOCK_SELF, ARG(CIDX, sched.idx))            \
+	X(SCHED_COMMIT, sched_commit, SCHED, SINGLE, LOCK_SELF, ARG(CIDX, sched.idx),          \
+	  ARG(TIME_SLOT, sched.slot))                                                          \
+	/* Instrumentation */                                                                  \
+	X(MON_SYSHIST_READ, mon_syshist_read, STATS, SINGLE, LOCK_SELF,                        \
+	  ARG(CIDX, mon_syshist.mon_idx), ARG(HART, mon_syshist.hart),                         \
+	  ARG(SYSCALL, mon_syshist.call), BUF(mon_syshist.hist, MEM_RW))                       \
+	/* Accounting */                                                                       \
+	X(MON_ACCT_READ, mon_acct_read, STATS, SINGLE, LOCK_SELF, ARG(CIDX, mon_acct.mon_idx), \
+	  ARG(PID, mon_acct.pid), BUF(mon_acct.acct, MEM_RW))                                  \
+	/* Tracing */                                                                          \
+	X(MON_TRACE_READ, mon_trace_read, STATS, SINGLE, LOCK_SELF, ARG(CIDX, mon_trace.mon_idx), \
+	  ARG(HART, mon_trace.hart), BUFN(mon_trace.buf, mon_trace.n, sizeof(trace_rec_t), MEM_RW)) \
+	/* Batching */                                                                         \
+	X(MULTICALL, multicall, CORE, SINGLE, NOLOCK,                                          \
+	  BUFN(multicall.ops, multicall.n, sizeof(multicall_op_t), MEM_R))                     \
+	/* Bulk capability reads */                                                            \
+	X(CAP_READ_RANGE, cap_read_range, CORE, SINGLE, NOLOCK, ARG(CIDX, cap_range.idx),      \
+	  BUFN(cap_range.buf, cap_range.n, sizeof(cap_t), MEM_RW))                             \
+	X(MON_CAP_READ_RANGE, mon_cap_read_range, MON, SINGLE, LOCK_PROC(mon_cap_range.pid),   \
+	  ARG(CIDX, mon_cap_range.mon_idx), ARG(PID, mon_cap_range.pid),                       \
+	  ARG(CIDX, mon_cap_range.idx),                                                        \
+	  BUFN(mon_cap_range.buf, mon_cap_range.n, sizeof(cap_t), MEM_RW))                     \
+	/* Capability lookup */                                                                \
+	X(CAP_FIND, cap_find, CORE, SINGLE, NOLOCK, ARG(CIDX, cap_find.idx))                   \
+	/* Derivation tree */                                                                  \
+	X(CAP_PARENT, cap_parent, CORE, SINGLE, LOCK_CTES(OWN_CTE(cap.idx)), ARG(CIDX, cap.idx)) \
+	X(CAP_DESCENDANTS, cap_descendants, CORE, SINGLE, NOLOCK, ARG(CIDX, cap.idx))
+
 typedef enum {
-	// Basic Info & Registers
-	SYS_GET_INFO,  // Retrieve basic system information
-	SYS_REG_READ,  // Set the value of a specific register
-	SYS_REG_WRITE, // Get the value of a specific register
-	SYS_SYNC,      // Synchronize with capabilities/scheduling
-
-	// Capability Management
-	SYS_CAP_READ,	// Read the properties of a capability
-	SYS_CAP_MOVE,	// Move a capability to a different slot
-	SYS_CAP_DELETE, // Remove a capability from the system
-	SYS_CAP_REVOKE, // Revoke a derived capabilities
-	SYS_CAP_DERIVE, // Derive a new capability from an existing one
-
-	// PMP
-	SYS_PMP_LOAD,
-	SYS_PMP_UNLOAD,
-
-	// Monitor
-	SYS_MON_SUSPEND,
-	SYS_MON_RESUME,
-	SYS_MON_STATE_GET,
-	SYS_MON_YIELD,
-	SYS_MON_REG_READ,
-	SYS_MON_REG_WRITE,
-	SYS_MON_CAP_READ,
-	SYS_MON_CAP_MOVE,
-	SYS_MON_PMP_LOAD,
-	SYS_MON_PMP_UNLOAD,
-
-	// Socket
-	SYS_SOCK_SEND,
-	SYS_SOCK_RECV,
-	SYS_SOCK_SENDRECV,
-
-	// Path+file calls
-	SYS_PATH_READ,
-	SYS_MON_PATH_READ,
-	SYS_PATH_DERIVE,
-	SYS_READ_FILE,
-	SYS_WRITE_FILE,
-	SYS_CREATE_DIR,
-	SYS_PATH_DELETE,
-	SYS_READ_DIR,
+#define X(NAME, ...) SYS_##NAME,
+	SYSCALLS(X)
+#undef X
+	SYS_CNT,
 } syscall_t;
 
 typedef union {
@@ -58,6 +129,10 @@ typedef union {
 
 	struct {
 		int info;
+		hart_t hart;
+		uint64_t lock;
+		uint64_t stat;
+		cidx_t mon_idx;
 	} get_info;
 
 	struct {
@@ -75,6 +150,19 @@ typedef union {
 		cap_t cap;
 	} cap;
 
+	struct {
+		cidx_t idx;
+		cap_t *buf;
+		uint64_t n;
+	} cap_range;
+
+	struct {
+		cidx_t idx;
+		uint64_t type;
+		uint64_t mask;
+		uint64_t val;
+	} cap_find;
+
 	struct {
 		cidx_t pmp_idx;
 		pmp_slot_t pmp_slot;
@@ -100,6 +188,14 @@ typedef union {
 		cidx_t dst_idx;
 	} mon_cap;
 
+	struct {
+		cidx_t mon_idx;
+		pid_t pid;
+		cidx_t idx;
+		cap_t *buf;
+		uint64_t n;
+	} mon_cap_range;
+
 	struct {
 		cidx_t mon_idx;
 		pid_t pid;
@@ -107,6 +203,44 @@ typedef union {
 		pmp_slot_t pmp_slot;
 	} mon_pmp;
 
+	struct {
+		cidx_t mon_idx;
+		pid_t pid;
+		hart_t hart;
+		bool enable;
+	} mon_slack;
+
+	struct {
+		cidx_t idx;
+		time_slot_t slot;
+	} sched;
+
+	struct {
+		cidx_t mon_idx;
+		hart_t hart;
+		uint64_t call;
+		syshist_t *hist;
+		bool reset;
+	} mon_syshist;
+
+	struct {
+		cidx_t mon_idx;
+		pid_t pid;
+		acct_t *acct;
+	} mon_acct;
+
+	struct {
+		cidx_t mon_idx;
+		hart_t hart;
+		trace_rec_t *buf;
+		uint64_t n;
+	} mon_trace;
+
+	struct {
+		const struct multicall_op *ops;
+		uint64_t n;
+	} multicall;
+
 	struct {
 		cidx_t sock_idx;
 		cidx_t cap_idx;
@@ -162,4 +296,10 @@ typedef union {
 
 _Static_assert(sizeof(sys_args_t) == 64, "sys_args_t has the wrong size");
 
+/** An operation of SYS_MULTICALL, a system call and its arguments. */
+typedef struct multicall_op {
+	uint64_t call;
+	sys_args_t args;
+} multicall_op_t;
+
 void handle_syscall(proc_t *p) __attribute__((noreturn));
@@ -0,0 +1,47 @@
+/**
+ * Per-hart system call latency histograms, collected if INSTRUMENT is
+ * defined.
+ *
+ * A sample is the cycles from the start of a system call handler, lock
+ * waits included, until it returns. Bin i counts the samples with
+ * floor(log2(cycles)) == SYSHIST_SHIFT + i, the first and last bins also
+ * count the samples below and above them. Without INSTRUMENT the histograms
+ * read as empty.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SYSHIST_BINS 12
+#define SYSHIST_SHIFT 6
+
+typedef struct syshist {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+	uint32_t bins[SYSHIST_BINS];
+} syshist_t;
+
+#ifdef INSTRUMENT
+/// Current cycle count, for the start of a sample.
+uint64_t syshist_now(void);
+/// Record a sample of call started at start on this hart.
+void syshist_record(uint64_t call, uint64_t start);
+#else
+static inline uint64_t syshist_now(void)
+{
+	return 0;
+}
+
+static inline void syshist_record(uint64_t call, uint64_t start)
+{
+}
+#endif
+
+/// Copy the histogram of call on hartid, optionally resetting it.
+void syshist_read(uint64_t hartid, uint64_t call, syshist_t *hist,
+		  bool reset);
+/// Longest system call on any hart, optionally resetting it.
+uint64_t syshist_wcet(bool reset);
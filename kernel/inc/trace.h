@@ -0,0 +1,58 @@
+/**
+ * Per-hart ring buffers of kernel events, recorded if S3K_TRACE is defined.
+ *
+ * Each hart writes only its own ring, S3K_TRACE_LEN records, overwriting the
+ * oldest. A root monitor drains a ring with SYS_MON_TRACE_READ. Records are
+ * numbered per hart, a gap in the numbers is records overwritten before they
+ * were drained.
+ * scripts/trace_decode.py turns drained records into per-hart timelines.
+ * Without S3K_TRACE nothing is recorded and the rings read as empty.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifndef S3K_TRACE_LEN
+#define S3K_TRACE_LEN 256
+#endif
+
+typedef enum {
+	TRACE_SCHED,	    // pid dispatched, arg: end of its slice.
+	TRACE_PREEMPT,	    // pid preempted at the end of its slice.
+	TRACE_YIELD,	    // pid left the hart before the end of its slice.
+	TRACE_SYSCALL,	    // pid called arg.
+	TRACE_SYSCALL_RET,  // pid returned from its system call, arg: error.
+	TRACE_IPC_SEND,	    // Message to pid, arg: channel.
+	TRACE_IPC_RECV,	    // pid waits for a message, arg: channel.
+	TRACE_EXCEPTION,    // Exception of pid, arg: mcause.
+} trace_event_t;
+
+typedef struct trace_rec {
+	uint64_t time; // Real-time clock.
+	uint32_t seq;  // Number of the record on its hart.
+	uint16_t pid;
+	uint8_t event;
+	uint8_t hart;
+	uint64_t arg;
+} trace_rec_t;
+
+#ifdef S3K_TRACE
+_Static_assert((S3K_TRACE_LEN & (S3K_TRACE_LEN - 1)) == 0,
+	       "S3K_TRACE_LEN must be a power of two");
+
+/// Record an event on this hart.
+void trace(trace_event_t event, uint64_t pid, uint64_t arg);
+/// Drain up to n records of a hart into buf, oldest first, returns the number
+/// of records written.
+uint64_t trace_read(uint64_t hart, trace_rec_t *buf, uint64_t n);
+#else
+static inline void trace(trace_event_t event, uint64_t pid, uint64_t arg)
+{
+}
+
+static inline uint64_t trace_read(uint64_t hart, trace_rec_t *buf,
+				  uint64_t n)
+{
+	return 0;
+}
+#endif
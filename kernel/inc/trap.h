@@ -7,6 +7,7 @@
  */
 #include <stdint.h>
 
+void trap_vector(void) __attribute__((noreturn));
 void trap_entry(void) __attribute__((noreturn));
 void trap_exit(proc_t *) __attribute__((noreturn));
 void trap_resume(proc_t *) __attribute__((noreturn));
@@ -0,0 +1,43 @@
+#include "acct.h"
+
+#include "csr.h"
+#include "drivers/time.h"
+#include "macro.h"
+
+static acct_t accts[S3K_PROC_CNT];
+
+// Time the running process got each hart.
+static struct {
+	uint64_t time;
+} __attribute__((aligned(CACHE_LINE))) entered[S3K_HART_CNT];
+
+void acct_dispatch(proc_t *p, uint64_t now, uint64_t start, uint64_t end)
+{
+	acct_t *a = &accts[p->pid];
+	a->alloc += end - now;
+	if (start > now)
+		a->sched += start - now;
+}
+
+void acct_enter(proc_t *p)
+{
+	entered[csrr_mhartid() - S3K_MIN_HART].time = time_get();
+}
+
+void acct_release(proc_t *p, bool yield)
+{
+	uint64_t hartid = csrr_mhartid();
+	uint64_t now = time_get();
+	acct_t *a = &accts[p->pid];
+	a->run += now - entered[hartid - S3K_MIN_HART].time;
+	if (yield) {
+		uint64_t end = timeout_get(hartid);
+		if (end > now)
+			a->unused += end - now;
+	}
+}
+
+void acct_read(pid_t pid, acct_t *acct)
+{
+	*acct = accts[pid];
+}
@@ -6,7 +6,9 @@
 #include "drivers/time.h"
 #include "error.h"
 #include "kassert.h"
+#include "kernel.h"
 #include "proc.h"
+#include "trace.h"
 
 #include <stdint.h>
 
@@ -15,6 +17,8 @@
 
 static proc_t *clients[S3K_CHAN_CNT];
 static proc_t *servers[S3K_CHAN_CNT];
+// Protects clients and servers of a channel, a leaf lock.
+static mcslock_t chan_locks[S3K_CHAN_CNT];
 
 void set_client(uint64_t chan, proc_t *proc, ipc_mode_t mode)
 {
@@ -55,6 +59,16 @@ err_t valid_sock(cap_t sock_cap, bool send_cap)
 	return SUCCESS;
 }
 
+proc_t *cap_sock_peer(cap_t sock_cap)
+{
+	if (sock_cap.type != CAPTY_SOCKET)
+		return NULL;
+	uint64_t chan = sock_cap.sock.chan;
+	bool is_server = (sock_cap.sock.tag == 0);
+	return __atomic_load_n(is_server ? &clients[chan] : &servers[chan],
+			       __ATOMIC_RELAXED);
+}
+
 err_t do_sock_send(cap_t sock_cap, const ipc_msg_t *msg, proc_t **next)
 {
 	uint64_t chan = sock_cap.sock.chan;
@@ -63,17 +77,27 @@ err_t do_sock_send(cap_t sock_cap, const ipc_msg_t *msg, proc_t **next)
 	uint64_t perm = sock_cap.sock.perm;
 	bool is_server = (tag == 0);
 
-	proc_t *recv = is_server ? clients[chan] : servers[chan];
-
 	bool send_data = (perm & (is_server ? IPC_SDATA : IPC_CDATA));
 
-	if (!recv || !proc_ipc_acquire(recv, chan))
+	kernel_lock_leaf(&chan_locks[chan]);
+	proc_t *recv = is_server ? clients[chan] : servers[chan];
+
+	// A capability can only go to the receiver whose buffer is locked.
+	// If the receiver changed, we act as if we sent before it waited.
+	if (!recv || (msg->send_cap && recv != msg->recv)
+	    || !proc_ipc_acquire(recv, chan)) {
+		kernel_unlock_leaf(&chan_locks[chan]);
 		return ERR_NO_RECEIVER;
+	}
 
 	if (is_server)
 		clients[chan] = NULL;
 	else
 		servers[chan] = NULL;
+	// Released before moving the capability, since the move may clear
+	// a socket.
+	kernel_unlock_leaf(&chan_locks[chan]);
+	trace(TRACE_IPC_SEND, recv->pid, chan);
 
 	recv->regs[REG_T0] = SUCCESS;
 	recv->regs[REG_A0] = tag;
@@ -114,10 +138,13 @@ err_t do_sock_recv(proc_t *recv, cap_t sock_cap)
 	if (recv_cap)
 		cap_delete(recv->cap_buf);
 
+	kernel_lock_leaf(&chan_locks[chan]);
 	if (is_server)
 		set_server(chan, recv, mode);
 	else
 		set_client(chan, recv, mode);
+	kernel_unlock_leaf(&chan_locks[chan]);
+	trace(TRACE_IPC_RECV, recv->pid, chan);
 	return YIELD;
 }
 
@@ -184,9 +211,11 @@ err_t cap_sock_sendrecv(cte_t sock, const ipc_msg_t *msg, proc_t **next)
 
 void cap_sock_clear(cap_t cap, proc_t *p)
 {
+	kernel_lock_leaf(&chan_locks[cap.sock.chan]);
 	if (!cap.sock.tag) {
 		servers[cap.sock.chan] = NULL;
 	} else if (clients[cap.sock.chan] == p) {
 		clients[cap.sock.chan] = NULL;
 	}
+	kernel_unlock_leaf(&chan_locks[cap.sock.chan]);
 }
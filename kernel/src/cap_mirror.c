@@ -0,0 +1,38 @@
+#include "cap_mirror.h"
+
+#include "cap_util.h"
+
+#ifdef S3K_CAP_MIRROR
+// The mirrors fill whole memory blocks, the boot process can read nothing
+// else of the kernel.
+#define MIRRORS_SIZE                                                       \
+	((S3K_PROC_CNT * CAP_MIRROR_SIZE + (1ull << MIN_BLOCK_SIZE) - 1) \
+	 & ~((1ull << MIN_BLOCK_SIZE) - 1))
+#define MIRRORS_ALIGN \
+	(CAP_MIRROR_SIZE > (1ull << MIN_BLOCK_SIZE) ? CAP_MIRROR_SIZE : (1ull << MIN_BLOCK_SIZE))
+
+static union {
+	union {
+		cap_mirror_t m;
+		uint8_t pad[CAP_MIRROR_SIZE];
+	} procs[S3K_PROC_CNT];
+	uint8_t pad[MIRRORS_SIZE];
+} mirrors __attribute__((aligned(MIRRORS_ALIGN)));
+
+void cap_mirror_set(uint64_t pid, uint64_t idx, cap_t cap)
+{
+	// Only the holder of the process's lock writes its mirror.
+	cap_mirror_t *m = &mirrors.procs[pid].m;
+	uint64_t gen = m->gen;
+	__atomic_store_n(&m->gen, gen + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&m->caps[idx].raw, cap.raw, __ATOMIC_RELAXED);
+	__atomic_store_n(&m->gen, gen + 2, __ATOMIC_RELEASE);
+}
+
+cap_t cap_mirror_cap(void)
+{
+	uint64_t base = (uint64_t)&mirrors;
+	return cap_mk_memory(base, base + sizeof(mirrors), MEM_R);
+}
+#endif
@@ -3,7 +3,9 @@
 #include "cap_fs.h"
 #include "cap_ops.h"
 #include "cap_pmp.h"
+#include "lockstat.h"
 #include "proc.h"
+#include "sched.h"
 
 static err_t check_monitor(cte_t mon, pid_t pid, bool check_suspended)
 {
@@ -15,6 +17,15 @@ static err_t check_monitor(cte_t mon, pid_t pid, bool check_suspended)
 	return SUCCESS;
 }
 
+static err_t check_root_monitor(cte_t mon)
+{
+	cap_t mon_cap = cte_cap(mon);
+	if (mon_cap.type != CAPTY_MONITOR || mon_cap.mon.bgn != 0
+	    || mon_cap.mon.end != S3K_PROC_CNT)
+		return ERR_INVALID_MONITOR;
+	return SUCCESS;
+}
+
 static err_t check_monitor_move(cte_t mon, cte_t src, cte_t dst)
 {
 	uint64_t mon_pid = cte_pid(mon);
@@ -92,6 +103,14 @@ err_t cap_monitor_cap_read(cte_t mon, cte_t src, cap_t *cap)
 	return err;
 }
 
+err_t cap_monitor_cap_read_range(cte_t mon, pid_t pid, cidx_t idx, uint64_t n, cap_t *buf)
+{
+	err_t err = check_monitor(mon, pid, true);
+	if (!err)
+		err = cap_read_range(pid, idx, n, buf);
+	return err;
+}
+
 err_t cap_monitor_cap_move(cte_t mon, cte_t src, cte_t dst)
 {
 	err_t err = check_monitor_move(mon, src, dst);
@@ -124,3 +143,66 @@ err_t cap_monitor_path_read(cte_t mon, cte_t path, char *buf, size_t n)
 		err = path_read(cte_cap(path), buf, n);
 	return err;
 }
+
+err_t cap_monitor_slack_set(cte_t mon, pid_t pid, hart_t hart, bool enable)
+{
+	err_t err = check_monitor(mon, pid, false);
+	if (err)
+		return err;
+
+	// Retry if another monitor changed the slack process meanwhile.
+	while (1) {
+		uint64_t curr = sched_slack_get(hart);
+		uint64_t next = enable ? pid : SCHED_NO_SLACK;
+		if (!enable && curr != pid)
+			return ERR_INVALID_STATE;
+		if (enable && curr != SCHED_NO_SLACK
+		    && (err = check_monitor(mon, curr, false)))
+			return err;
+		if (sched_slack_set(hart, curr, next))
+			return SUCCESS;
+	}
+}
+
+err_t cap_monitor_syshist_read(cte_t mon, hart_t hart, uint64_t call,
+			       syshist_t *hist, bool reset)
+{
+	err_t err = check_root_monitor(mon);
+	if (!err)
+		syshist_read(hart, call, hist, reset);
+	return err;
+}
+
+err_t cap_monitor_acct_read(cte_t mon, pid_t pid, acct_t *acct)
+{
+	err_t err = check_monitor(mon, pid, false);
+	if (!err)
+		acct_read(pid, acct);
+	return err;
+}
+
+err_t cap_monitor_trace_read(cte_t mon, hart_t hart, trace_rec_t *buf,
+			     uint64_t n, uint64_t *cnt)
+{
+	err_t err = check_root_monitor(mon);
+	if (!err)
+		*cnt = trace_read(hart, buf, n);
+	return err;
+}
+
+err_t cap_monitor_wcet_reset(cte_t mon, uint64_t *wcet)
+{
+	err_t err = check_root_monitor(mon);
+	if (!err)
+		*wcet = syshist_wcet(true);
+	return err;
+}
+
+err_t cap_monitor_lockstat_reset(cte_t mon, hart_t hart, uint64_t lock,
+				 uint64_t stat, uint64_t *val)
+{
+	err_t err = check_root_monitor(mon);
+	if (!err)
+		*val = lockstat_get(hart, lock, stat, true);
+	return err;
+}
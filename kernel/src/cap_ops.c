@@ -12,6 +12,16 @@ err_t cap_read(cte_t c, cap_t *cap)
 	return cap->raw ? SUCCESS : ERR_EMPTY;
 }
 
+err_t cap_read_range(pid_t pid, cidx_t idx, uint64_t n, cap_t *buf)
+{
+	// Empty entries read as zero, the type CAPTY_NONE.
+	if (n > (uint64_t)S3K_CAP_CNT - idx)
+		return ERR_INVALID_INDEX;
+	for (uint64_t i = 0; i < n; i++)
+		buf[i] = cte_cap(ctable_get(pid, idx + i));
+	return SUCCESS;
+}
+
 static void ipc_move_hook(cte_t src, cte_t dst)
 {
 	cap_t cap = cte_cap(src);
@@ -22,7 +32,8 @@ static void ipc_move_hook(cte_t src, cte_t dst)
 		uint64_t hartid = cap.time.hart;
 		uint64_t from = cap.time.mrk;
 		uint64_t to = cap.time.end;
-		sched_update(pid, end, hartid, from, to);
+		bool slack = cap.time.slack;
+		sched_update(pid, end, hartid, from, to, slack);
 	} break;
 	case CAPTY_PMP:
 		if (cap.pmp.used) {
@@ -48,6 +59,9 @@ err_t cap_move(cte_t src, cte_t dst, cap_t *cap)
 	if (cte_cap(dst).type)
 		return ERR_DST_OCCUPIED;
 
+	// A staging does not follow its capability.
+	if (cte_cap(src).type == CAPTY_TIME)
+		sched_unstage(cte_cap(src).time.hart, src);
 	if (cte_pid(src) != cte_pid(dst))
 		ipc_move_hook(src, dst);
 	cte_move(src, dst, cap);
@@ -62,6 +76,7 @@ static void delete_hook(cte_t c, cap_t cap)
 		uint64_t hartid = cap.time.hart;
 		uint64_t from = cap.time.mrk;
 		uint64_t end = cap.time.end;
+		sched_unstage(hartid, c);
 		sched_delete(hartid, from, end);
 	} break;
 	case CAPTY_PMP:
@@ -89,21 +104,17 @@ err_t cap_delete(cte_t c)
 
 void cap_reclaim(cte_t p, cap_t pcap, cte_t c, cap_t ccap)
 {
-	if ((cte_prev(c) != p) || cte_cap(c).raw != ccap.raw)
+	if ((cte_parent(c) != p) || cte_cap(c).raw != ccap.raw)
 		return;
 
 	cte_delete(c);
 
 	switch (ccap.type) {
-	case CAPTY_TIME: {
+	case CAPTY_TIME:
+		sched_unstage(ccap.time.hart, c);
+		// The slots are scheduled by cap_reclaim_sched().
 		pcap.time.mrk = ccap.time.mrk;
-		uint64_t pid = cte_pid(p);
-		uint64_t end = pcap.time.end;
-		uint64_t hartid = pcap.time.hart;
-		uint64_t from = pcap.time.mrk;
-		uint64_t to = pcap.time.end;
-		sched_update(pid, end, hartid, from, to);
-	} break;
+		break;
 	case CAPTY_MEMORY:
 		pcap.mem.mrk = ccap.mem.mrk;
 		pcap.mem.lck = ccap.mem.lck;
@@ -137,6 +148,19 @@ void cap_reclaim(cte_t p, cap_t pcap, cte_t c, cap_t ccap)
 	return;
 }
 
+void cap_reclaim_sched(cte_t p, time_slot_t from)
+{
+	// Schedule the process of p in the slots taken back from its children,
+	// once for all children reclaimed under the same locks.
+	cap_t pcap = cte_cap(p);
+	uint64_t pid = cte_pid(p);
+	uint64_t end = pcap.time.end;
+	uint64_t hartid = pcap.time.hart;
+	uint64_t to = pcap.time.end;
+	bool slack = pcap.time.slack;
+	sched_reclaim(pid, end, hartid, from, to, slack);
+}
+
 err_t cap_reset(cte_t c)
 {
 	if (!cte_cap(c).type)
@@ -150,7 +174,8 @@ err_t cap_reset(cte_t c)
 		uint64_t hartid = cap.time.hart;
 		uint64_t from = cap.time.bgn;
 		uint64_t to = cap.time.mrk;
-		sched_update(pid, end, hartid, from, to);
+		bool slack = cap.time.slack;
+		sched_reclaim(pid, end, hartid, from, to, slack);
 		cap.time.mrk = cap.time.bgn;
 	} break;
 	case CAPTY_MEMORY:
@@ -182,7 +207,8 @@ static void derive(cte_t src, cap_t scap, cte_t dst, cap_t ncap)
 		uint64_t hartid = ncap.time.hart;
 		uint64_t from = ncap.time.mrk;
 		uint64_t to = ncap.time.end;
-		sched_update(pid, end, hartid, from, to);
+		bool slack = ncap.time.slack;
+		sched_update(pid, end, hartid, from, to, slack);
 		scap.time.mrk = ncap.time.end;
 	} break;
 	case CAPTY_MEMORY:
@@ -223,3 +249,24 @@ err_t cap_derive(cte_t src, cte_t dst, cap_t ncap)
 	derive(src, scap, dst, ncap);
 	return SUCCESS;
 }
+
+err_t cap_time_stage(cte_t c)
+{
+	cap_t cap = cte_cap(c);
+	if (!cap.type)
+		return ERR_EMPTY;
+	if (cap.type != CAPTY_TIME)
+		return ERR_INVALID_TIME;
+	// Only the slots not given to children.
+	return sched_stage(cap.time.hart, c, cap.time.mrk, cap.time.end);
+}
+
+err_t cap_time_commit(cte_t c, time_slot_t slot)
+{
+	cap_t cap = cte_cap(c);
+	if (!cap.type)
+		return ERR_EMPTY;
+	if (cap.type != CAPTY_TIME)
+		return ERR_INVALID_TIME;
+	return sched_commit(cap.time.hart, cap.time.bgn, cap.time.end, slot);
+}
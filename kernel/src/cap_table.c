@@ -1,28 +1,84 @@
 #include "cap_table.h"
 
+#include "cap_mirror.h"
 #include "cap_util.h"
 #include "kassert.h"
+#include "macro.h"
 
-#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+#define CAPTY_CNT (CAPTY_PATH + 1)
+#define BITMAP_WORDS ((S3K_CAP_CNT + 63) / 64)
+#define CTREE_NONE UINT32_MAX
 
-struct cte {
-	uint32_t prev, next;
-	cap_t cap;
-};
+// Not static, read by the system call fast path in trap.S.
+struct cte ctable[S3K_PROC_CNT * S3K_CAP_CNT];
 
-static struct cte ctable[S3K_PROC_CNT * S3K_CAP_CNT];
+// Entries of each process by capability type, bit i % 64 of word i / 64 for
+// index i. Bitmap CAPTY_NONE holds the occupied entries. Updated with the
+// capabilities, under the lock of the process.
+static uint64_t bitmaps[S3K_PROC_CNT][CAPTY_CNT][BITMAP_WORDS];
+
+// Derivation tree of ctable by offset, CTREE_NONE for no entry. The first
+// child of an entry is its next entry in the derivation list, the other
+// children follow in sibling order. The initial capabilities are roots
+// without siblings. The links of an entry are protected by the lock of its
+// parent's process, which kernel_lock_ctes() takes.
+static struct ctree {
+	uint32_t parent, prev, next;
+} ctree[S3K_PROC_CNT * S3K_CAP_CNT];
+
+static const struct ctree ctree_none = {CTREE_NONE, CTREE_NONE, CTREE_NONE};
 
 static uint32_t offset(cte_t c)
 {
 	return (uint32_t)(c - ctable);
 }
 
+static void bitmaps_update(cte_t c, capty_t old, capty_t new)
+{
+	uint64_t(*maps)[BITMAP_WORDS] = bitmaps[cte_pid(c)];
+	uint64_t i = cte_idx(c);
+	uint64_t w = i / 64, bit = 1ull << (i % 64);
+	KASSERT(old < CAPTY_CNT && new < CAPTY_CNT);
+	if (old != CAPTY_NONE)
+		maps[old][w] &= ~bit;
+	if (new != CAPTY_NONE) {
+		maps[new][w] |= bit;
+		maps[CAPTY_NONE][w] |= bit;
+	} else {
+		maps[CAPTY_NONE][w] &= ~bit;
+	}
+}
+
+static cte_t ctree_cte(uint32_t i)
+{
+	return i == CTREE_NONE ? NULL : &ctable[i];
+}
+
+static void list_insert(cte_t c, cte_t prev)
+{
+	cte_set_prev(c, prev);
+	cte_set_next(c, cte_next(prev));
+	cte_set_next(cte_prev(c), c);
+	cte_set_prev(cte_next(c), c);
+}
+
+static void root_insert(cte_t c, cap_t cap, cte_t prev)
+{
+	list_insert(c, prev);
+	cte_set_cap(c, cap);
+}
+
 void ctable_init(void)
 {
 	const cap_t init_caps[] = INIT_CAPS;
 	cte_t prev = ctable;
+	for (unsigned int i = 0; i < ARRAY_SIZE(ctree); ++i)
+		ctree[i] = ctree_none;
 	for (unsigned int i = 0; i < ARRAY_SIZE(init_caps); ++i)
-		cte_insert(&ctable[i], init_caps[i], prev);
+		root_insert(&ctable[i], init_caps[i], prev);
+#ifdef S3K_CAP_MIRROR
+	root_insert(&ctable[ARRAY_SIZE(init_caps)], cap_mirror_cap(), prev);
+#endif
 }
 
 cte_t ctable_get(uint64_t pid, uint64_t index)
@@ -49,7 +105,9 @@ void cte_set_prev(cte_t c, cte_t prev)
 
 void cte_set_cap(cte_t c, cap_t cap)
 {
+	bitmaps_update(c, c->cap.type, cap.type);
 	c->cap = cap;
+	cap_mirror_set(cte_pid(c), cte_idx(c), cap);
 }
 
 cte_t cte_next(cte_t c)
@@ -72,11 +130,62 @@ pid_t cte_pid(cte_t c)
 	return (pid_t)(offset(c) / S3K_CAP_CNT);
 }
 
+cidx_t cte_idx(cte_t c)
+{
+	return (cidx_t)(offset(c) % S3K_CAP_CNT);
+}
+
+cte_t cte_parent(cte_t c)
+{
+	return ctree_cte(ctree[offset(c)].parent);
+}
+
+cte_t cte_child(cte_t c)
+{
+	cte_t next = cte_next(c);
+	return ctree[offset(next)].parent == offset(c) ? next : NULL;
+}
+
+cte_t cte_sibling(cte_t c)
+{
+	return ctree_cte(ctree[offset(c)].next);
+}
+
+uint64_t cte_descendants(cte_t c, bool owners[])
+{
+	// Preorder walk of the subtree, climbing back up from its leaves. It
+	// follows each link at most twice, the bound stops a walk whose links
+	// change under it.
+	uint64_t n = 0, steps = 0;
+	cte_t d = cte_child(c);
+	while (d && steps++ < 2 * ARRAY_SIZE(ctree)) {
+		n++;
+		owners[cte_pid(d)] = true;
+		cte_t next = cte_child(d);
+		while (!next && d && d != c && steps++ < 2 * ARRAY_SIZE(ctree)) {
+			next = cte_sibling(d);
+			d = cte_parent(d);
+		}
+		d = next;
+	}
+	return n;
+}
+
 void cte_move(cte_t src, cte_t dst, cap_t *cap)
 {
 	*cap = src->cap;
 	if (src == dst)
 		return;
+	uint32_t s = offset(src), d = offset(dst);
+	struct ctree n = ctree[s];
+	for (cte_t k = cte_child(src); k; k = cte_sibling(k))
+		ctree[offset(k)].parent = d;
+	if (n.prev != CTREE_NONE)
+		ctree[n.prev].next = d;
+	if (n.next != CTREE_NONE)
+		ctree[n.next].prev = d;
+	ctree[d] = n;
+	ctree[s] = ctree_none;
 	cte_set_cap(src, (cap_t){0});
 	cte_set_prev(dst, cte_prev(src));
 	cte_set_next(dst, cte_next(src));
@@ -88,17 +197,66 @@ void cte_move(cte_t src, cte_t dst, cap_t *cap)
 cap_t cte_delete(cte_t c)
 {
 	cap_t cap = cte_cap(c);
+	uint32_t i = offset(c);
+	struct ctree n = ctree[i];
+	// The children of c take its place among its siblings, as they do in
+	// the derivation list. Children of a root become roots.
+	cte_t child = cte_child(c);
+	uint32_t first = child ? offset(child) : n.next;
+	uint32_t last = n.prev;
+	for (uint32_t j = child ? first : CTREE_NONE, next; j != CTREE_NONE; j = next) {
+		next = ctree[j].next;
+		ctree[j].parent = n.parent;
+		if (n.parent == CTREE_NONE)
+			ctree[j] = ctree_none;
+		last = j;
+	}
+	if (n.parent != CTREE_NONE) {
+		if (child) {
+			ctree[first].prev = n.prev;
+			ctree[last].next = n.next;
+		}
+		if (n.prev != CTREE_NONE)
+			ctree[n.prev].next = first;
+		if (n.next != CTREE_NONE)
+			ctree[n.next].prev = last;
+	}
+	ctree[i] = ctree_none;
 	cte_set_cap(c, (cap_t){0});
 	cte_set_next(cte_prev(c), cte_next(c));
 	cte_set_prev(cte_next(c), cte_prev(c));
 	return cap;
 }
 
-void cte_insert(cte_t c, cap_t cap, cte_t prev)
+void cte_insert(cte_t c, cap_t cap, cte_t parent)
 {
-	cte_set_prev(c, prev);
-	cte_set_next(c, cte_next(prev));
-	cte_set_next(cte_prev(c), c);
-	cte_set_prev(cte_next(c), c);
+	uint32_t i = offset(c), p = offset(parent);
+	cte_t first = cte_child(parent);
+	ctree[i] = (struct ctree){p, CTREE_NONE, first ? offset(first) : CTREE_NONE};
+	if (first)
+		ctree[offset(first)].prev = i;
+	list_insert(c, parent);
 	cte_set_cap(c, cap);
 }
+
+uint64_t ctable_find(uint64_t pid, uint64_t idx, capty_t type, uint64_t mask, uint64_t val)
+{
+	KASSERT(pid < S3K_PROC_CNT);
+	KASSERT(type < CAPTY_CNT);
+	for (uint64_t w = idx / 64; w < BITMAP_WORDS; w++) {
+		uint64_t bits = bitmaps[pid][type][w];
+		if (type == CAPTY_NONE)
+			bits = ~bits;
+		// Skip the entries before idx.
+		if (w == idx / 64)
+			bits &= ~0ull << (idx % 64);
+		for (; bits; bits &= bits - 1) {
+			uint64_t i = w * 64 + __builtin_ctzll(bits);
+			if (i >= S3K_CAP_CNT)
+				break;
+			if (((ctable_get(pid, i)->cap.raw ^ val) & mask) == 0)
+				return i;
+		}
+	}
+	return S3K_CAP_CNT;
+}
@@ -26,6 +26,13 @@ void csrw_mcycle(uint64_t val)
 	__asm__ volatile("csrw mcycle,%0" ::"r"(val));
 }
 
+uint64_t csrr_minstret(void)
+{
+	uint64_t val;
+	__asm__ volatile("csrr %0,minstret" : "=r"(val));
+	return val;
+}
+
 uint64_t csrr_mhpmcounter3(void)
 {
 	uint64_t val;
@@ -33,11 +40,52 @@ uint64_t csrr_mhpmcounter3(void)
 	return val;
 }
 
+uint64_t csrr_mhpmcounter4(void)
+{
+	uint64_t val;
+	__asm__ volatile("csrr %0,mhpmcounter4" : "=r"(val));
+	return val;
+}
+
+uint64_t csrr_mhpmcounter5(void)
+{
+	uint64_t val;
+	__asm__ volatile("csrr %0,mhpmcounter5" : "=r"(val));
+	return val;
+}
+
+uint64_t csrr_mhpmcounter6(void)
+{
+	uint64_t val;
+	__asm__ volatile("csrr %0,mhpmcounter6" : "=r"(val));
+	return val;
+}
+
 void csrw_mhpmcounter3(uint64_t val)
 {
 	__asm__ volatile("csrw mhpmcounter3,%0" ::"r"(val));
 }
 
+void csrw_mhpmevent3(uint64_t val)
+{
+	__asm__ volatile("csrw mhpmevent3,%0" ::"r"(val));
+}
+
+void csrw_mhpmevent4(uint64_t val)
+{
+	__asm__ volatile("csrw mhpmevent4,%0" ::"r"(val));
+}
+
+void csrw_mhpmevent5(uint64_t val)
+{
+	__asm__ volatile("csrw mhpmevent5,%0" ::"r"(val));
+}
+
+void csrw_mhpmevent6(uint64_t val)
+{
+	__asm__ volatile("csrw mhpmevent6,%0" ::"r"(val));
+}
+
 void csrw_mstatus(uint64_t val)
 {
 	__asm__ volatile("csrw mstatus,%0" ::"r"(val));
@@ -53,6 +101,16 @@ void csrc_mstatus(uint64_t val)
 	__asm__ volatile("csrc mstatus,%0" ::"r"(val));
 }
 
+void csrs_mie(uint64_t val)
+{
+	__asm__ volatile("csrs mie,%0" ::"r"(val));
+}
+
+void csrc_mie(uint64_t val)
+{
+	__asm__ volatile("csrc mie,%0" ::"r"(val));
+}
+
 uint64_t csrr_pmpcfg0(void)
 {
 	uint64_t val;
@@ -1,8 +1,10 @@
 /* See LICENSE file for copyright and license details. */
 #include "exception.h"
 
+#include "fpu.h"
 #include "kernel.h"
 #include "proc.h"
+#include "trace.h"
 #include "trap.h"
 
 #define ILLEGAL_INSTRUCTION 0x2
@@ -17,11 +19,15 @@ static void handle_default(proc_t *p, uint64_t mcause, uint64_t mepc,
 
 void handle_exception(proc_t *p, uint64_t mcause, uint64_t mepc, uint64_t mtval)
 {
+	trace(TRACE_EXCEPTION, p->pid, mcause);
 	/* Check if it is a return from exception */
 	if (mcause == ILLEGAL_INSTRUCTION
 	    && (mtval == MRET || mtval == SRET || mtval == URET))
 		// Handle return from exception
 		handle_ret(p);
+	// First floating-point instruction since p got this hart
+	if (mcause == ILLEGAL_INSTRUCTION && fpu_trap(p))
+		trap_resume(p);
 	// Handle default exception
 	handle_default(p, mcause, mepc, mtval);
 }
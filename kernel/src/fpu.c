@@ -0,0 +1,92 @@
+#include "fpu.h"
+
+#include "csr.h"
+#include "trap.h"
+
+#ifdef S3K_FPU
+static volatile uint32_t *const msip = (uint32_t *)MSIP_BASE_ADDR;
+
+// Process whose context the floating-point registers of each hart hold.
+static proc_t *owner[S3K_HART_CNT];
+// Set if another hart waits for this hart to save its owner's context.
+static bool save_req[S3K_HART_CNT];
+
+static bool is_loaded(proc_t *p, uint64_t hartid)
+{
+	return owner[hartid - S3K_MIN_HART] == p && p->fpu.hart == hartid;
+}
+
+/// True if p's context is newer in the registers of a hart than in p->fpu.
+static bool is_dirty(proc_t *p)
+{
+	return __atomic_load_n(&p->fpu.dirty, __ATOMIC_ACQUIRE);
+}
+
+/// Save the context of the owner of this hart's registers if it is dirty.
+static void owner_save(uint64_t hartid)
+{
+	proc_t *q = owner[hartid - S3K_MIN_HART];
+	// Dirty first, a dirty context of another hart comes with its hart.
+	if (!q || !is_dirty(q) || q->fpu.hart != hartid)
+		return;
+	fpu_save(&q->fpu);
+	__atomic_store_n(&q->fpu.dirty, false, __ATOMIC_RELEASE);
+}
+
+void fpu_release(proc_t *p)
+{
+	// The context stays in the registers until another process needs them.
+	if (p->fpu.fs == MSTATUS_FS_DIRTY)
+		__atomic_store_n(&p->fpu.dirty, true, __ATOMIC_RELEASE);
+}
+
+void fpu_dispatch(proc_t *p)
+{
+	uint64_t hartid = p->fpu.hart;
+	if (!is_dirty(p) || hartid == csrr_mhartid())
+		return;
+	// Migrated, ask the hart holding the context to save it.
+	__atomic_store_n(&save_req[hartid - S3K_MIN_HART], true,
+			 __ATOMIC_RELEASE);
+	msip[hartid] = 1;
+}
+
+void fpu_enter(proc_t *p)
+{
+	p->fpu.fs = is_loaded(p, csrr_mhartid()) ? MSTATUS_FS_CLEAN
+						 : MSTATUS_FS_OFF;
+}
+
+void fpu_sync(void)
+{
+	uint64_t hartid = csrr_mhartid();
+	if (__atomic_exchange_n(&save_req[hartid - S3K_MIN_HART], false,
+				__ATOMIC_ACQUIRE))
+		owner_save(hartid);
+}
+
+void fpu_ipi(proc_t *p)
+{
+	msip[csrr_mhartid()] = 0;
+	fpu_sync();
+	// Exit from the start, we may have interrupted an exit to p.
+	trap_exit(p);
+}
+
+bool fpu_trap(proc_t *p)
+{
+	uint64_t hartid = csrr_mhartid();
+	if (p->fpu.fs != MSTATUS_FS_OFF)
+		return false;
+	// Wait for the hart p migrated from to save its context, and serve
+	// the requests to us meanwhile, the other hart may wait for us.
+	while (is_dirty(p) && p->fpu.hart != hartid)
+		fpu_sync();
+	owner_save(hartid);
+	fpu_restore(&p->fpu);
+	owner[hartid - S3K_MIN_HART] = p;
+	p->fpu.hart = hartid;
+	p->fpu.fs = MSTATUS_FS_CLEAN;
+	return true;
+}
+#endif
@@ -0,0 +1,61 @@
+#include "hpm.h"
+
+#include "csr.h"
+#include "macro.h"
+
+#ifdef S3K_HPM_CNT
+// Counter values sampled when the running process got the hart.
+typedef struct {
+	uint64_t cycle;
+	uint64_t instret;
+	uint64_t hpm[S3K_HPM_CNT];
+} __attribute__((aligned(CACHE_LINE))) sample_t;
+
+static sample_t samples[S3K_HART_CNT];
+
+static uint64_t (*const hpm_read[4])(void) = {
+    csrr_mhpmcounter3,
+    csrr_mhpmcounter4,
+    csrr_mhpmcounter5,
+    csrr_mhpmcounter6,
+};
+
+static void (*const hpm_event_write[4])(uint64_t) = {
+    csrw_mhpmevent3,
+    csrw_mhpmevent4,
+    csrw_mhpmevent5,
+    csrw_mhpmevent6,
+};
+
+static sample_t *sample_get(void)
+{
+	return &samples[csrr_mhartid() - S3K_MIN_HART];
+}
+
+void hpm_enter(proc_t *p)
+{
+	sample_t *s = sample_get();
+	for (int i = 0; i < S3K_HPM_CNT; i++) {
+		hpm_event_write[i](p->regs[REG_HPMEVENT3 + i]
+				   & S3K_HPM_EVENT_MASK);
+		s->hpm[i] = hpm_read[i]();
+	}
+	s->instret = csrr_minstret();
+	s->cycle = csrr_mcycle();
+}
+
+void hpm_release(proc_t *p)
+{
+	sample_t *s = sample_get();
+	p->regs[REG_CYCLE] += csrr_mcycle() - s->cycle;
+	p->regs[REG_INSTRET] += csrr_minstret() - s->instret;
+	for (int i = 0; i < S3K_HPM_CNT; i++)
+		p->regs[REG_HPMCOUNTER3 + i] += hpm_read[i]() - s->hpm[i];
+}
+
+void hpm_sync(proc_t *p)
+{
+	hpm_release(p);
+	hpm_enter(p);
+}
+#endif
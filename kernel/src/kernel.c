@@ -10,13 +10,34 @@
 #include "proc.h"
 #include "sched.h"
 
-static mcslock_t lock;
-static uint64_t wcet;
+// Most locks a hart holds at once: the process locks of kernel_lock_ctes(),
+// or of all processes, the file system lock and a leaf lock.
+#define PROC_LOCK_MAX (4 * KERNEL_CTE_MAX > S3K_PROC_CNT ? 4 * KERNEL_CTE_MAX : S3K_PROC_CNT)
+#define LOCK_MAX (PROC_LOCK_MAX + 2)
+// Queue nodes per hart. Nodes of abandoned waits stay in their queues until
+// the lock holder passes them, the spare nodes cover those.
+#define QNODE_CNT (2 * LOCK_MAX)
+
+// Locks held by a hart, released in reverse order.
+typedef struct lock_stack {
+	qnode_t qnodes[QNODE_CNT];
+	mcslock_t *locks[LOCK_MAX];
+	qnode_t *nodes[LOCK_MAX];
+	uint64_t cnt;
+} lock_stack_t;
+
+// Capability table and process locks, taken in ascending pid order.
+static mcslock_t proc_locks[S3K_PROC_CNT];
+// File system lock, taken after the process locks.
+static mcslock_t fs_lock;
+static lock_stack_t held[S3K_HART_CNT];
 
 void kernel_init(void)
 {
 	alt_init();
-	mcslock_init(&lock);
+	for (uint64_t i = 0; i < S3K_PROC_CNT; i++)
+		mcslock_init(&proc_locks[i]);
+	mcslock_init(&fs_lock);
 	ctable_init();
 	sched_init();
 	proc_init();
@@ -24,40 +45,132 @@ void kernel_init(void)
 	alt_puts("kernel initialized");
 }
 
-uint64_t kernel_wcet(void)
+static lock_stack_t *held_get(void)
+{
+	return &held[csrr_mhartid() - S3K_MIN_HART];
+}
+
+static qnode_t *qnode_get(lock_stack_t *s)
 {
-	return wcet;
+	// A node is only busy for longer than its lock is held if its wait was
+	// abandoned, so some node is freed shortly.
+	while (1) {
+		for (uint64_t i = 0; i < QNODE_CNT; i++) {
+			if (qnode_is_free(&s->qnodes[i]))
+				return &s->qnodes[i];
+		}
+	}
 }
 
-void kernel_wcet_reset(void)
+static bool push(mcslock_t *lock, bool preemptive)
 {
-	wcet = 0;
+	lock_stack_t *s = held_get();
+	KASSERT(s->cnt < LOCK_MAX);
+	qnode_t *qnode = qnode_get(s);
+	if (!preemptive)
+		mcslock_acquire(lock, qnode);
+	else if (!mcslock_try_acquire(lock, qnode))
+		return false;
+	s->locks[s->cnt] = lock;
+	s->nodes[s->cnt++] = qnode;
+	return true;
 }
 
-bool kernel_lock(proc_t *p)
+static void pop(void)
 {
-	kernel_hook_sys_exit(p);
-	bool res = mcslock_try_acquire(&lock, &p->qnode);
-	kernel_hook_sys_entry(p);
+	lock_stack_t *s = held_get();
+	KASSERT(s->cnt > 0);
+	s->cnt--;
+	mcslock_release(s->locks[s->cnt], s->nodes[s->cnt]);
+}
+
+bool kernel_lock_procs(proc_t *p, uint64_t n, uint64_t pids[])
+{
+	// Sort so all harts take the locks in the same order.
+	for (uint64_t i = 1; i < n; i++) {
+		uint64_t pid = pids[i];
+		uint64_t j = i;
+		for (; j > 0 && pids[j - 1] > pid; j--)
+			pids[j] = pids[j - 1];
+		pids[j] = pid;
+	}
+
+	bool res = true;
+	for (uint64_t i = 0; res && i < n; i++) {
+		if (i > 0 && pids[i] == pids[i - 1])
+			continue;
+		res = push(&proc_locks[pids[i]], true);
+	}
+	if (!res)
+		kernel_unlock(p);
 	return res;
 }
 
-void kernel_unlock(proc_t *p)
+bool kernel_lock_ctes(proc_t *p, uint64_t n, const cte_t ctes[])
+{
+	cte_t prev[KERNEL_CTE_MAX], next[KERNEL_CTE_MAX], parent[KERNEL_CTE_MAX];
+	uint64_t pids[4 * KERNEL_CTE_MAX];
+
+	KASSERT(n <= KERNEL_CTE_MAX);
+	while (1) {
+		// Guess the neighbours and the parent, they can only change
+		// while we do not hold the locks of the entry's process and of
+		// the parent's process.
+		for (uint64_t i = 0; i < n; i++) {
+			prev[i] = cte_prev(ctes[i]);
+			next[i] = cte_next(ctes[i]);
+			parent[i] = cte_parent(ctes[i]);
+			pids[4 * i] = cte_pid(ctes[i]);
+			pids[4 * i + 1] = cte_pid(prev[i]);
+			pids[4 * i + 2] = cte_pid(next[i]);
+			pids[4 * i + 3] = cte_pid(parent[i] ? parent[i] : ctes[i]);
+		}
+		if (!kernel_lock_procs(p, 4 * n, pids))
+			return false;
+		bool stable = true;
+		for (uint64_t i = 0; i < n; i++) {
+			stable &= (cte_prev(ctes[i]) == prev[i]);
+			stable &= (cte_next(ctes[i]) == next[i]);
+			stable &= (cte_parent(ctes[i]) == parent[i]);
+		}
+		if (stable)
+			return true;
+		kernel_unlock(p);
+	}
+}
+
+bool kernel_holds_proc(uint64_t pid)
 {
-	mcslock_release(&lock, &p->qnode);
+	lock_stack_t *s = held_get();
+	for (uint64_t i = 0; i < s->cnt; i++) {
+		if (s->locks[i] == &proc_locks[pid])
+			return true;
+	}
+	return false;
 }
 
-void kernel_hook_sys_entry(proc_t *p)
+bool kernel_lock_fs(proc_t *p)
 {
-#ifdef INSTRUMENT
-	csrw_mcycle(0);
-#endif
+	bool res = push(&fs_lock, true);
+	if (!res)
+		kernel_unlock(p);
+	return res;
 }
 
-void kernel_hook_sys_exit(proc_t *p)
+void kernel_lock_leaf(mcslock_t *lock)
+{
+	push(lock, false);
+}
+
+void kernel_unlock_leaf(mcslock_t *lock)
+{
+	lock_stack_t *s = held_get();
+	KASSERT(s->cnt > 0 && s->locks[s->cnt - 1] == lock);
+	pop();
+}
+
+void kernel_unlock(proc_t *p)
 {
-#ifdef INSTRUMENT
-	uint64_t cycles = csrr_mcycle();
-	__asm__ volatile("amomax.d x0,%0,(%1)" ::"r"(cycles), "r"(&wcet));
-#endif
+	while (held_get()->cnt > 0)
+		pop();
 }
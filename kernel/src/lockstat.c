@@ -0,0 +1,55 @@
+#include "lockstat.h"
+
+#include "csr.h"
+#include "macro.h"
+
+#ifdef INSTRUMENT
+// Each hart only adds to its own statistics, other harts read and reset
+// them.
+static struct {
+	uint64_t s[LOCKSTAT_LOCK_CNT][LOCKSTAT_STAT_CNT];
+} __attribute__((aligned(CACHE_LINE))) stats[S3K_HART_CNT];
+
+static uint64_t *hart_stats(lockstat_lock_t lock)
+{
+	return stats[csrr_mhartid() - S3K_MIN_HART].s[lock];
+}
+
+uint64_t lockstat_now(void)
+{
+	return csrr_mcycle();
+}
+
+void lockstat_attempt(lockstat_lock_t lock, uint64_t start, bool acquired)
+{
+	uint64_t *s = hart_stats(lock);
+	uint64_t spin = csrr_mcycle() - start;
+	__atomic_fetch_add(&s[acquired ? LOCKSTAT_ACQUIRED : LOCKSTAT_FAILED],
+			   1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&s[LOCKSTAT_SPIN], spin, __ATOMIC_RELAXED);
+}
+
+void lockstat_release(lockstat_lock_t lock, uint64_t start)
+{
+	uint64_t *s = hart_stats(lock);
+	uint64_t hold = csrr_mcycle() - start;
+	__asm__ volatile("amomax.du x0,%0,(%1)" ::"r"(hold),
+			 "r"(&s[LOCKSTAT_HOLD_MAX]));
+}
+#endif
+
+uint64_t lockstat_get(uint64_t hartid, uint64_t lock, uint64_t stat,
+		      bool reset)
+{
+#ifdef INSTRUMENT
+	if ((hartid - S3K_MIN_HART) >= S3K_HART_CNT
+	    || lock >= LOCKSTAT_LOCK_CNT || stat >= LOCKSTAT_STAT_CNT)
+		return 0;
+	uint64_t *s = &stats[hartid - S3K_MIN_HART].s[lock][stat];
+	if (reset)
+		return __atomic_exchange_n(s, 0, __ATOMIC_RELAXED);
+	return __atomic_load_n(s, __ATOMIC_RELAXED);
+#else
+	return 0;
+#endif
+}
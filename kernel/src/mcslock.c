@@ -1,48 +1,73 @@
-// TODO: Replace with proper MCS Lock
+/**
+ * MCS queue lock with abortable waits.
+ *
+ * Each waiter enqueues its own node and spins only on the node's state,
+ * which the predecessor sets to QNODE_GRANTED when it releases the lock. A
+ * preempted waiter marks its node QNODE_ABANDONED instead of unlinking it,
+ * the releaser then skips the node and frees it on the waiter's behalf.
+ * Grant and abandon race on the same compare-and-swap, so exactly one of
+ * them wins.
+ */
 #include "mcslock.h"
 
 #include "kassert.h"
+#include "lockstat.h"
 #include "preempt.h"
 
 #include <stddef.h>
 
-static void _release(qnode_t *const node)
+static void _free(qnode_t *node)
 {
-	qnode_t *expected, *next, *prev;
-	prev = __atomic_exchange_n(&node->prev, NULL, __ATOMIC_RELAXED);
-	do {
-		expected = node;
-		next = node->next;
-	} while (!__atomic_compare_exchange_n(&next->prev, &expected, prev,
-					      false, __ATOMIC_RELEASE,
-					      __ATOMIC_RELAXED));
-	if (prev)
-		prev->next = next;
+	__atomic_store_n(&node->state, QNODE_FREE, __ATOMIC_RELEASE);
 }
 
-static bool _acquire(mcslock_t *lock, qnode_t *const node, bool preemptive)
+static bool _wait(mcslock_t *lock, qnode_t *const node, bool preemptive)
 {
 	if (preemptive && preempt())
 		return false;
-	node->next = &lock->tail;
-	node->prev
-	    = __atomic_exchange_n(&lock->tail.prev, node, __ATOMIC_ACQUIRE);
-	if (node->prev == NULL)
+	node->next = NULL;
+	node->state = QNODE_WAITING;
+	qnode_t *pred
+	    = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+	if (!pred) {
+		node->state = QNODE_GRANTED;
 		return true;
-	node->prev->next = node;
-	while (__atomic_load_n(&node->prev, __ATOMIC_ACQUIRE)) {
+	}
+	__atomic_store_n(&pred->next, node, __ATOMIC_RELEASE);
+	while (__atomic_load_n(&node->state, __ATOMIC_ACQUIRE)
+	       == QNODE_WAITING) {
 		if (preemptive && preempt()) {
-			_release(node);
-			return false;
+			uint64_t expected = QNODE_WAITING;
+			if (__atomic_compare_exchange_n(
+				&node->state, &expected, QNODE_ABANDONED,
+				false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+				return false;
+			// Granted while aborting, keep the lock.
+			break;
 		}
 	}
 	return true;
 }
 
+static bool _acquire(mcslock_t *lock, qnode_t *const node, bool preemptive)
+{
+	KASSERT(qnode_is_free(node));
+	uint64_t start = lockstat_now();
+	bool acquired = _wait(lock, node, preemptive);
+	lockstat_attempt(LOCKSTAT_MCS, start, acquired);
+	if (acquired)
+		node->stamp = lockstat_now();
+	return acquired;
+}
+
 void mcslock_init(mcslock_t *lock)
 {
-	// lock->tail.prev = lock->tail.next = NULL;
-	lock->tail.prev = lock->tail.next = NULL;
+	lock->tail = NULL;
+}
+
+bool qnode_is_free(const qnode_t *qnode)
+{
+	return __atomic_load_n(&qnode->state, __ATOMIC_ACQUIRE) == QNODE_FREE;
 }
 
 void mcslock_acquire(mcslock_t *lock, qnode_t *node)
@@ -57,5 +82,31 @@ bool mcslock_try_acquire(mcslock_t *lock, qnode_t *node)
 
 void mcslock_release(mcslock_t *lock, qnode_t *node)
 {
-	_release(node);
+	lockstat_release(LOCKSTAT_MCS, node->stamp);
+	while (1) {
+		qnode_t *next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+		if (!next) {
+			qnode_t *expected = node;
+			if (__atomic_compare_exchange_n(&lock->tail, &expected,
+							NULL, false,
+							__ATOMIC_RELEASE,
+							__ATOMIC_RELAXED)) {
+				_free(node);
+				return;
+			}
+			// A successor is enqueueing, wait for the link.
+			while (!(next = __atomic_load_n(&node->next,
+							__ATOMIC_ACQUIRE)))
+				;
+		}
+		uint64_t expected = QNODE_WAITING;
+		bool granted = __atomic_compare_exchange_n(
+		    &next->state, &expected, QNODE_GRANTED, false,
+		    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+		_free(node);
+		if (granted)
+			return;
+		// The successor abandoned its node, release on its behalf.
+		node = next;
+	}
 }
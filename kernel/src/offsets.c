@@ -0,0 +1,93 @@
+/**
+ * @file offsets.c
+ * @brief Layout of kernel structures for assembly.
+ *
+ * Compiled to assembly only, the Makefile turns each DEFINE() into a
+ * #define of the generated offsets.h.
+ */
+#include "cap_table.h"
+#include "proc.h"
+#include "syscall.h"
+
+#include <stddef.h>
+
+#define DEFINE(sym, val) __asm__ volatile("\n.ascii \"->" #sym " %0\"" ::"i"(val))
+#define REG(sym, reg) DEFINE(sym, offsetof(proc_t, regs[reg]))
+
+_Static_assert((sizeof(struct cte) & (sizeof(struct cte) - 1)) == 0,
+	       "CTE_LOG_SIZE");
+_Static_assert(sizeof(pmp_installed_t) == CACHE_LINE, "PMP_INSTALLED_LOG_SIZE");
+
+void offsets(void)
+{
+	/* Register offsets */
+	REG(PROC_PC, REG_PC);
+	REG(PROC_RA, REG_RA);
+	REG(PROC_SP, REG_SP);
+	REG(PROC_GP, REG_GP);
+	REG(PROC_TP, REG_TP);
+	REG(PROC_T0, REG_T0);
+	REG(PROC_T1, REG_T1);
+	REG(PROC_T2, REG_T2);
+	REG(PROC_S0, REG_S0);
+	REG(PROC_S1, REG_S1);
+	REG(PROC_A0, REG_A0);
+	REG(PROC_A1, REG_A1);
+	REG(PROC_A2, REG_A2);
+	REG(PROC_A3, REG_A3);
+	REG(PROC_A4, REG_A4);
+	REG(PROC_A5, REG_A5);
+	REG(PROC_A6, REG_A6);
+	REG(PROC_A7, REG_A7);
+	REG(PROC_S2, REG_S2);
+	REG(PROC_S3, REG_S3);
+	REG(PROC_S4, REG_S4);
+	REG(PROC_S5, REG_S5);
+	REG(PROC_S6, REG_S6);
+	REG(PROC_S7, REG_S7);
+	REG(PROC_S8, REG_S8);
+	REG(PROC_S9, REG_S9);
+	REG(PROC_S10, REG_S10);
+	REG(PROC_S11, REG_S11);
+	REG(PROC_T3, REG_T3);
+	REG(PROC_T4, REG_T4);
+	REG(PROC_T5, REG_T5);
+	REG(PROC_T6, REG_T6);
+
+	/* Virtual registers, REG_TPC to REG_CYCLE, not live in the CPU. The
+	 * performance counters are folded in by the slow path, see hpm.h. */
+	DEFINE(VREG_FIRST, REG_TPC);
+	DEFINE(VREG_END, REG_CYCLE);
+
+	/* PMP registers */
+	DEFINE(PROC_PMPCFG0, offsetof(proc_t, pmpcfg));
+	DEFINE(PROC_PMPADDR0, offsetof(proc_t, pmpaddr[0]));
+	DEFINE(PROC_PMPADDR1, offsetof(proc_t, pmpaddr[1]));
+	DEFINE(PROC_PMPADDR2, offsetof(proc_t, pmpaddr[2]));
+	DEFINE(PROC_PMPADDR3, offsetof(proc_t, pmpaddr[3]));
+	DEFINE(PROC_PMPADDR4, offsetof(proc_t, pmpaddr[4]));
+	DEFINE(PROC_PMPADDR5, offsetof(proc_t, pmpaddr[5]));
+	DEFINE(PROC_PMPADDR6, offsetof(proc_t, pmpaddr[6]));
+	DEFINE(PROC_PMPADDR7, offsetof(proc_t, pmpaddr[7]));
+	DEFINE(PROC_PMP_GEN, offsetof(proc_t, pmp_gen));
+	DEFINE(PMP_INSTALLED_LOG_SIZE, __builtin_ctz(sizeof(pmp_installed_t)));
+	DEFINE(PMP_INSTALLED_PROC, offsetof(pmp_installed_t, proc));
+	DEFINE(PMP_INSTALLED_GEN, offsetof(pmp_installed_t, pmp_gen));
+
+	DEFINE(PROC_PID, offsetof(proc_t, pid));
+
+#ifdef S3K_FPU
+	/* Floating-point context */
+	DEFINE(PROC_FPU_FS, offsetof(proc_t, fpu.fs));
+	DEFINE(FPU_FCSR, offsetof(fpu_t, fcsr));
+#endif
+
+	/* Capability table entry */
+	DEFINE(CTE_LOG_SIZE, __builtin_ctz(sizeof(struct cte)));
+	DEFINE(CTE_CAP, offsetof(struct cte, cap));
+
+	/* System calls of the fast path in trap.S */
+	DEFINE(SYSNR_GET_INFO, SYS_GET_INFO);
+	DEFINE(SYSNR_REG_READ, SYS_REG_READ);
+	DEFINE(SYSNR_CAP_READ, SYS_CAP_READ);
+}
@@ -5,8 +5,11 @@
 #include "csr.h"
 #include "drivers/time.h"
 #include "kassert.h"
+#include "sched.h"
 
 static proc_t _processes[S3K_PROC_CNT];
+// Not static, kept by trap_exit.
+pmp_installed_t pmp_installed[S3K_HART_CNT];
 extern unsigned char _payload[];
 
 void proc_init(void)
@@ -57,6 +60,8 @@ void proc_release(proc_t *proc)
 	// Unset the busy flag.
 	KASSERT(proc->state & PSF_BUSY);
 	__atomic_fetch_and(&proc->state, (uint64_t)~PSF_BUSY, __ATOMIC_RELEASE);
+	// An idle hart may be waiting for the process.
+	sched_kick();
 }
 
 void proc_suspend(proc_t *proc)
@@ -78,6 +83,8 @@ void proc_resume(proc_t *proc)
 	// Unset the suspend flag
 	__atomic_fetch_and(&proc->state, (uint64_t)~PSF_SUSPENDED,
 			   __ATOMIC_RELEASE);
+	// The process may own a slot that an idle hart sleeps through.
+	sched_kick();
 }
 
 void proc_ipc_wait(proc_t *proc, chan_t channel)
@@ -124,9 +131,11 @@ void proc_pmp_load(proc_t *proc, pmp_slot_t slot, pmp_slot_t rwx, napot_t addr)
 {
 	proc->pmpcfg[slot] = (uint8_t)(rwx | 0x18);
 	proc->pmpaddr[slot] = addr;
+	proc->pmp_gen++;
 }
 
 void proc_pmp_unload(proc_t *proc, pmp_slot_t slot)
 {
 	proc->pmpcfg[slot] = 0;
+	proc->pmp_gen++;
 }
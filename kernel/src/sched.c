@@ -2,24 +2,302 @@
 
 #include "sched.h"
 
+#include "acct.h"
+#include "altc/altio.h"
 #include "csr.h"
 #include "drivers/time.h"
+#include "fpu.h"
+#include "hpm.h"
 #include "kassert.h"
 #include "kernel.h"
+#include "lockstat.h"
+#include "macro.h"
 #include "proc.h"
 #include "semaphore.h"
+#include "trace.h"
 #include "trap.h"
 #include "wfi.h"
 
+#ifdef S3K_MINOR_SLOT_LENS
+#ifndef S3K_MINOR_CNT
+#define S3K_MINOR_CNT 1
+#endif
+
+// Slot lengths of one minor frame, repeated S3K_MINOR_CNT times per period,
+// or of every slot of the period, so each minor frame has its own layout.
+static const uint64_t minor_slot_lens[] = S3K_MINOR_SLOT_LENS;
+
+_Static_assert(ARRAY_SIZE(minor_slot_lens) * S3K_MINOR_CNT == S3K_SLOT_CNT
+		   || ARRAY_SIZE(minor_slot_lens) == S3K_SLOT_CNT,
+	       "S3K_MINOR_SLOT_LENS must have the slots of one minor frame "
+	       "or of the whole period");
+
+// Start of each slot relative to the start of the period, the last entry is
+// the length of the period.
+static uint64_t slot_offset[S3K_SLOT_CNT + 1];
+
+/// Slot (in global sense) at time.
+static uint64_t slot_at(uint64_t time)
+{
+	uint64_t period = slot_offset[S3K_SLOT_CNT];
+	uint64_t offset = time % period;
+	uint64_t lo = 0, hi = S3K_SLOT_CNT;
+	// Find the last slot starting at or before offset.
+	while (hi - lo > 1) {
+		uint64_t mid = (lo + hi) / 2;
+		if (slot_offset[mid] <= offset)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return (time / period) * S3K_SLOT_CNT + lo;
+}
+
+/// Start time of slot (in global sense).
+static uint64_t slot_start(uint64_t slot)
+{
+	uint64_t period = slot_offset[S3K_SLOT_CNT];
+	return (slot / S3K_SLOT_CNT) * period
+	       + slot_offset[slot % S3K_SLOT_CNT];
+}
+
+static void slot_offset_init(void)
+{
+	uint64_t offset = 0;
+	for (uint64_t i = 0; i < S3K_SLOT_CNT; i++) {
+		uint64_t len = minor_slot_lens[i % ARRAY_SIZE(minor_slot_lens)];
+		// The scheduling time must fit in the first slot of a slice,
+		// checked also with NDEBUG since it is configuration.
+		if (len < S3K_SCHED_TIME) {
+			alt_puts("Slot shorter than S3K_SCHED_TIME.");
+			while (1)
+				;
+		}
+		slot_offset[i] = offset;
+		offset += len;
+	}
+	slot_offset[S3K_SLOT_CNT] = offset;
+}
+#else
+static uint64_t slot_at(uint64_t time)
+{
+	return time / S3K_SLOT_LEN;
+}
+
+static uint64_t slot_start(uint64_t slot)
+{
+	return slot * S3K_SLOT_LEN;
+}
+
+static void slot_offset_init(void)
+{
+}
+#endif
+
 typedef struct slot_info {
 	// Owner of time slot.
 	uint32_t pid;
 	// Remaining length of corresponding slice.
-	uint32_t length;
+	uint32_t length : 31;
+	// Set if unused time is lent to the slack process.
+	uint32_t slack : 1;
 } slot_info_t;
 
-static slot_info_t slots[S3K_HART_CNT][S3K_SLOT_CNT];
+/**
+ * What a hart runs in a slot.
+ *
+ * Entries are resolved by the writers from the slot tables of all harts and
+ * published as single words, so sched_fetch() needs one load and no lock.
+ */
+typedef union dispatch {
+	struct {
+		// Process to run.
+		uint32_t pid;
+		// Remaining length of the slice, 0 if the hart has nothing to run.
+		uint32_t length : 30;
+		// Set if the slot is the first in its slice.
+		uint32_t first : 1;
+		// Set if the slack process may run when pid cannot.
+		uint32_t slack : 1;
+	};
+
+	uint64_t raw;
+} dispatch_t;
+
+typedef struct sched_row {
+	// Slot owners as given by the time capabilities.
+	slot_info_t slots[S3K_SLOT_CNT];
+	// Resolved schedule, read by sched_fetch().
+	dispatch_t dispatch[S3K_SLOT_CNT];
+} __attribute__((aligned(64))) sched_row_t;
+
+/**
+ * The live row and the shadow row of a hart.
+ *
+ * The rows are equal except while the hart has a staged schedule, then the
+ * stager's updates to the staged slots only go to the shadow row. A commit
+ * publishes the shadow row from a chosen slot on, see flip.
+ */
+typedef struct sched_hart {
+	sched_row_t rows[2];
+	// Slot from which row (flip & 1) is live, earlier slots use the other.
+	uint64_t flip;
+	// Slots being staged in the shadow row, and the time capability that
+	// staged them, NULL if none.
+	struct {
+		const void *owner;
+		uint64_t from, to;
+	} staging;
+} sched_hart_t;
+
+static sched_hart_t sched_harts[S3K_HART_CNT];
+// Serializes writers, readers never take it.
 static semaphore_t sched_semaphore;
+// When sched_semaphore was acquired, for lock statistics.
+static uint64_t sched_stamp;
+// Bitmask of harts sleeping in sched_idle(), bit 0 is S3K_MIN_HART.
+static uint64_t idle_harts;
+// Process run in slack slots whose owner cannot run.
+static uint64_t slack_pid[S3K_HART_CNT];
+// Time each hart has spent in sched_idle().
+static uint64_t idle_time[S3K_HART_CNT];
+// Machine software interrupt pending registers, one per hart.
+static volatile uint32_t *const msip = (uint32_t *)MSIP_BASE_ADDR;
+
+static void sched_lock(void)
+{
+	uint64_t start = lockstat_now();
+	semaphore_acquire(&sched_semaphore);
+	lockstat_attempt(LOCKSTAT_SCHED, start, true);
+	sched_stamp = lockstat_now();
+}
+
+static void sched_unlock(void)
+{
+	lockstat_release(LOCKSTAT_SCHED, sched_stamp);
+	semaphore_release(&sched_semaphore);
+}
+
+static sched_hart_t *hart_get(uint64_t hartid)
+{
+	return &sched_harts[hartid - S3K_MIN_HART];
+}
+
+static uint64_t flip_get(uint64_t hartid)
+{
+	return __atomic_load_n(&hart_get(hartid)->flip, __ATOMIC_ACQUIRE);
+}
+
+/// Index of the row used for slot, given flip.
+static uint64_t row_idx(uint64_t f, uint64_t slot)
+{
+	return (slot >= (f >> 1)) ? (f & 1) : (f & 1) ^ 1;
+}
+
+static slot_info_t slot_info_get(uint64_t hartid, uint64_t row, uint64_t slot)
+{
+	return hart_get(hartid)->rows[row].slots[slot % S3K_SLOT_CNT];
+}
+
+static dispatch_t dispatch_get(uint64_t hartid, uint64_t slot)
+{
+	sched_row_t *row = &hart_get(hartid)->rows[row_idx(flip_get(hartid), slot)];
+	dispatch_t d;
+	d.raw = __atomic_load_n(&row->dispatch[slot % S3K_SLOT_CNT].raw,
+				__ATOMIC_RELAXED);
+	return d;
+}
+
+static dispatch_t dispatch_resolve(uint64_t hartid, uint64_t row, uint64_t slot)
+{
+	slot_info_t si = slot_info_get(hartid, row, slot);
+	dispatch_t d = {.raw = 0};
+
+	// If length = 0, then slice is deleted.
+	if (si.length == 0)
+		return d;
+
+	// If the owner also has the slot on other harts, the hart with the
+	// longest remaining slice runs it. On a tie, the lowest hart ID wins.
+	// Other harts count with their most recently committed row.
+	for (uint64_t i = S3K_MIN_HART; i <= S3K_MAX_HART; i++) {
+		if (i == hartid)
+			continue;
+		slot_info_t other_si = slot_info_get(i, hart_get(i)->flip & 1, slot);
+		if (si.pid != other_si.pid)
+			continue;
+		if (i < hartid && si.length <= other_si.length)
+			return d;
+		if (i > hartid && si.length < other_si.length)
+			return d;
+	}
+
+	d.pid = si.pid;
+	d.length = si.length;
+	d.slack = si.slack;
+	d.first = (slot_info_get(hartid, row, slot + S3K_SLOT_CNT - 1).length
+		   == 0);
+	return d;
+}
+
+/// Resolve the dispatch entries of all harts for slots from to to.
+static void dispatch_refresh(uint64_t from, uint64_t to)
+{
+	// Slot `to' is included since its `first' flag depends on slot to-1.
+	for (uint64_t i = from; i <= to; i++) {
+		uint64_t slot = i % S3K_SLOT_CNT;
+		for (uint64_t hartid = S3K_MIN_HART; hartid <= S3K_MAX_HART;
+		     hartid++) {
+			for (uint64_t row = 0; row < 2; row++) {
+				dispatch_t d = dispatch_resolve(hartid, row, slot);
+				__atomic_store_n(&hart_get(hartid)
+						      ->rows[row]
+						      .dispatch[slot]
+						      .raw,
+						 d.raw, __ATOMIC_RELAXED);
+			}
+		}
+	}
+}
+
+void sched_kick(void)
+{
+	// Order prior stores before reading idle_harts, pairs with the
+	// fetch-or in sched_idle().
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	uint64_t harts = __atomic_load_n(&idle_harts, __ATOMIC_RELAXED);
+	for (uint64_t i = 0; harts; ++i, harts >>= 1) {
+		if (harts & 1)
+			msip[S3K_MIN_HART + i] = 1;
+	}
+}
+
+/// Give slots from-to of hartid to pid until end, end = 0 deletes them.
+/// Unless live is set, staged slots only go to the shadow row.
+static void slots_write(uint64_t hartid, uint64_t from, uint64_t to,
+			uint64_t pid, uint64_t end, bool slack, bool live)
+{
+	sched_hart_t *h = hart_get(hartid);
+	sched_lock();
+	// Read under the lock, a commit changes the shadow row.
+	uint64_t shadow = (h->flip & 1) ^ 1;
+	for (uint64_t i = from; i < to; i++) {
+		bool staged = !live && h->staging.owner
+			      && h->staging.from <= i && i < h->staging.to;
+		slot_info_t si = {
+		    .pid = pid,
+		    .length = end > i ? end - i : 0,
+		    .slack = slack,
+		};
+		for (uint64_t row = 0; row < 2; row++) {
+			if (!staged || row == shadow)
+				h->rows[row].slots[i] = si;
+		}
+	}
+	dispatch_refresh(from, to);
+	sched_unlock();
+	sched_kick();
+}
 
 void sched_init(void)
 {
@@ -28,104 +306,251 @@ void sched_init(void)
 	uint64_t from = 0;
 	uint64_t to = S3K_SLOT_CNT;
 
-	semaphore_init(&sched_semaphore, S3K_HART_CNT);
+	semaphore_init(&sched_semaphore, 1);
+	slot_offset_init();
 
-	for (uint64_t hartid = S3K_MIN_HART; hartid <= S3K_MAX_HART; hartid++)
-		sched_update(pid, end, hartid, from, to);
+	for (uint64_t hartid = S3K_MIN_HART; hartid <= S3K_MAX_HART; hartid++) {
+		slack_pid[hartid - S3K_MIN_HART] = SCHED_NO_SLACK;
+		sched_update(pid, end, hartid, from, to, false);
+	}
 }
 
 void sched_update(uint64_t pid, uint64_t end, uint64_t hartid, uint64_t from,
+		  uint64_t to, bool slack)
+{
+	slots_write(hartid, from, to, pid, end, slack, false);
+}
+
+void sched_reclaim(uint64_t pid, uint64_t end, uint64_t hartid, uint64_t from,
+		   uint64_t to, bool slack)
+{
+	slots_write(hartid, from, to, pid, end, slack, true);
+}
+
+void sched_delete(uint64_t hartid, uint64_t from, uint64_t to)
+{
+	slots_write(hartid, from, to, 0, 0, false, true);
+}
+
+err_t sched_stage(uint64_t hartid, const void *owner, uint64_t from,
 		  uint64_t to)
 {
-	// Acquire all resources, blocking everyone else.
-	semaphore_acquire_n(&sched_semaphore, S3K_HART_CNT);
-	for (uint64_t i = from; i < to; i++) {
-		slots[hartid - S3K_MIN_HART][i].pid = pid & 0xFF;
-		slots[hartid - S3K_MIN_HART][i].length = (end - i) & 0xFF;
+	sched_hart_t *h = hart_get(hartid);
+	err_t err = SUCCESS;
+	sched_lock();
+	uint64_t f = h->flip;
+	if (h->staging.owner || slot_at(time_get()) < (f >> 1)) {
+		// Already staging, or the last commit is not live yet.
+		err = ERR_INVALID_STATE;
+	} else {
+		// The old row is no longer read, make it the shadow.
+		h->rows[(f & 1) ^ 1] = h->rows[f & 1];
+		h->staging.owner = owner;
+		h->staging.from = from;
+		h->staging.to = to;
 	}
-	// Release the resources.
-	semaphore_release_n(&sched_semaphore, S3K_HART_CNT);
+	sched_unlock();
+	return err;
 }
 
-void sched_delete(uint64_t hartid, uint64_t from, uint64_t to)
+void sched_unstage(uint64_t hartid, const void *owner)
+{
+	sched_hart_t *h = hart_get(hartid);
+	sched_lock();
+	if (h->staging.owner == owner) {
+		// Publish the staged slots now, as if they were never staged,
+		// so the schedule keeps matching the time capabilities.
+		uint64_t live = h->flip & 1;
+		for (uint64_t i = h->staging.from; i < h->staging.to; i++)
+			h->rows[live].slots[i] = h->rows[live ^ 1].slots[i];
+		dispatch_refresh(h->staging.from, h->staging.to);
+		h->staging.owner = NULL;
+	}
+	sched_unlock();
+	sched_kick();
+}
+
+err_t sched_commit(uint64_t hartid, uint64_t from, uint64_t to, uint64_t slot)
 {
-	semaphore_acquire_n(&sched_semaphore, S3K_HART_CNT);
-	for (uint64_t i = from; i < to; ++i) {
-		slots[hartid - S3K_MIN_HART][i].pid = 0;
-		slots[hartid - S3K_MIN_HART][i].length = 0;
+	sched_hart_t *h = hart_get(hartid);
+	err_t err = SUCCESS;
+	sched_lock();
+	if (!h->staging.owner || h->staging.from < from || to < h->staging.to) {
+		err = ERR_INVALID_STATE;
+	} else {
+		// Next occurrence of slot, at least one slot ahead so the hart
+		// is not reading it.
+		uint64_t now = slot_at(time_get()) + 1;
+		uint64_t at = now + (slot + S3K_SLOT_CNT - now % S3K_SLOT_CNT)
+					% S3K_SLOT_CNT;
+		uint64_t shadow = (h->flip & 1) ^ 1;
+		__atomic_store_n(&h->flip, (at << 1) | shadow, __ATOMIC_RELEASE);
+		h->staging.owner = NULL;
+		// Other harts resolve against the committed row.
+		dispatch_refresh(0, S3K_SLOT_CNT - 1);
 	}
-	// Release the resources.
-	semaphore_release_n(&sched_semaphore, S3K_HART_CNT);
+	sched_unlock();
+	if (!err)
+		sched_kick();
+	return err;
+}
+
+uint64_t sched_slack_get(uint64_t hartid)
+{
+	return __atomic_load_n(&slack_pid[hartid - S3K_MIN_HART],
+			       __ATOMIC_RELAXED);
 }
 
-slot_info_t slot_info_get(uint64_t hartid, uint64_t slot)
+bool sched_slack_set(uint64_t hartid, uint64_t curr, uint64_t pid)
 {
-	return slots[hartid - S3K_MIN_HART][slot % S3K_SLOT_CNT];
+	if (!__atomic_compare_exchange_n(&slack_pid[hartid - S3K_MIN_HART],
+					 &curr, pid, false, __ATOMIC_RELAXED,
+					 __ATOMIC_RELAXED))
+		return false;
+	sched_kick();
+	return true;
+}
+
+/// Try to acquire the slack process for a slot whose owner cannot run.
+static proc_t *sched_slack(uint64_t hartid, dispatch_t d)
+{
+	if (!d.slack)
+		return NULL;
+
+	uint64_t pid = sched_slack_get(hartid);
+	if (pid == SCHED_NO_SLACK || pid == d.pid)
+		return NULL;
+
+	proc_t *p = proc_get(pid);
+	if (!proc_acquire(p))
+		return NULL;
+	return p;
 }
 
 static proc_t *sched_fetch(uint64_t hartid, uint64_t *start_time,
 			   uint64_t *end_time)
 {
-	semaphore_acquire(&sched_semaphore);
-
 	// Get time slot (in global sense)
-	uint64_t slot = time_get() / S3K_SLOT_LEN;
-	// Get time slot information
-	slot_info_t si = slot_info_get(hartid, slot);
-	// Check if time slot is first in time slice.
-	bool first = (slot_info_get(hartid, slot - 1).length == 0);
-
-	// If length = 0, then slice is deleted.
-	if (si.length == 0)
-		goto fail;
-
-	// Have priority over harts with lower ID when scheduling length is
-	// longer.
-	for (uint64_t i = S3K_MIN_HART; i < hartid; i++) {
-		slot_info_t other_si = slot_info_get(i, slot);
-		if (si.pid == other_si.pid && si.length <= other_si.length)
-			goto fail;
-	}
+	uint64_t slot = slot_at(time_get());
+	// Get what this hart should run in the slot.
+	dispatch_t d = dispatch_get(hartid, slot);
+	uint64_t flip_slot = flip_get(hartid) >> 1;
 
-	// Have priority over harts with higher ID when scheduling length is
-	// equal or longer.
-	for (uint64_t i = hartid + 1; i < S3K_MAX_HART; i++) {
-		slot_info_t other_si = slot_info_get(i, slot);
-		if (si.pid == other_si.pid && si.length < other_si.length)
-			goto fail;
-	}
+	// Nothing to run, slice deleted or run by another hart.
+	if (d.length == 0)
+		return NULL;
 
 	// Get the process.
-	proc_t *p = proc_get(si.pid);
+	proc_t *p = proc_get(d.pid);
+	uint64_t length = d.length;
 
 	// Try to acquire the process.
-	if (!proc_acquire(p))
-		goto fail;
-	semaphore_release(&sched_semaphore);
-	*start_time = slot * S3K_SLOT_LEN + (first ? S3K_SCHED_TIME : 0);
-	*end_time = (slot + si.length) * S3K_SLOT_LEN;
+	if (!proc_acquire(p)) {
+		// The owner is blocked, suspended or busy. Lend the slot to
+		// the slack process, the owner gets it back at the next slot.
+		p = sched_slack(hartid, d);
+		if (!p)
+			return NULL;
+		length = 1;
+	}
+	// Slices of the old row end when a committed row goes live.
+	if (slot < flip_slot && flip_slot < slot + length)
+		length = flip_slot - slot;
+	bool first = d.first || slot == flip_slot;
+	*start_time = slot_start(slot) + (first ? S3K_SCHED_TIME : 0);
+	*end_time = slot_start(slot + length);
 	p->timeout = *end_time;
+	fpu_dispatch(p);
 	return p;
+}
 
-fail:
-	semaphore_release(&sched_semaphore);
-	return NULL;
+/// Time at which the next slice after slot may run, at most one frame ahead.
+static uint64_t sched_next_start(uint64_t hartid, uint64_t slot)
+{
+	dispatch_t d = dispatch_get(hartid, slot);
+	if (d.length != 0) {
+		// The owner was busy, blocked or suspended. Releasing or
+		// resuming it kicks us, a timeout does not. It may also have
+		// become ready before we announced that we sleep.
+		proc_t *p = proc_get(d.pid);
+		uint64_t state = __atomic_load_n(&p->state, __ATOMIC_ACQUIRE);
+		uint64_t wake = slot_start(slot + 1);
+		if (state == 0)
+			return 0;
+		if ((state & PSF_BLOCKED) && p->timeout < wake)
+			return p->timeout;
+		return wake;
+	}
+	for (uint64_t i = 1; i < S3K_SLOT_CNT; ++i) {
+		if (dispatch_get(hartid, slot + i).length != 0)
+			return slot_start(slot + i);
+	}
+	return slot_start(slot + S3K_SLOT_CNT);
+}
+
+/// Sleep until the next slice may run or the schedule changes.
+static void sched_idle(uint64_t hartid)
+{
+	uint64_t bit = 1ull << (hartid - S3K_MIN_HART);
+	uint64_t begin = time_get();
+
+	// Announce that we sleep before looking at the schedule, so a
+	// writer either sees the bit or we see its update.
+	__atomic_fetch_or(&idle_harts, bit, __ATOMIC_SEQ_CST);
+	msip[hartid] = 0;
+	csrs_mie(MIE_MSIE);
+
+	uint64_t wake = sched_next_start(hartid, slot_at(begin));
+	timeout_set(hartid, wake);
+	// The software interrupt is never taken since mstatus.MIE is off in
+	// the kernel, it only ends the wfi.
+	if (time_get() < wake)
+		wfi();
+
+	csrc_mie(MIE_MSIE);
+	__atomic_fetch_and(&idle_harts, ~bit, __ATOMIC_RELAXED);
+	msip[hartid] = 0;
+	// The interrupt may also be a request to save floating-point state.
+	fpu_sync();
+	idle_time[hartid - S3K_MIN_HART] += time_get() - begin;
+}
+
+uint64_t sched_idle_time(uint64_t hartid)
+{
+	// Unsigned, so hart IDs below S3K_MIN_HART wrap around.
+	uint64_t i = hartid - S3K_MIN_HART;
+	if (i >= S3K_HART_CNT)
+		return 0;
+	return __atomic_load_n(&idle_time[i], __ATOMIC_RELAXED);
 }
 
 void sched(proc_t *p)
 {
 	uint64_t hartid = csrr_mhartid();
 	uint64_t start_time, end_time;
-	if (p)
+	if (p) {
+		trace(time_get() < timeout_get(hartid) ? TRACE_YIELD
+						       : TRACE_PREEMPT,
+		      p->pid, 0);
+		fpu_release(p);
+		hpm_release(p);
+		acct_release(p, true);
 		proc_release(p);
+	}
 
-	do {
-		p = sched_fetch(hartid, &start_time, &end_time);
-	} while (!p);
+	while (!(p = sched_fetch(hartid, &start_time, &end_time)))
+		sched_idle(hartid);
+	acct_dispatch(p, time_get(), start_time, end_time);
+	trace(TRACE_SCHED, p->pid, end_time);
 
-	timeout_set(hartid, end_time);
+	// Sleep through the scheduling time at the start of the slice.
+	timeout_set(hartid, start_time);
 	while (time_get() < start_time)
-		;
+		wfi();
+	timeout_set(hartid, end_time);
 
+	fpu_enter(p);
+	hpm_enter(p);
+	acct_enter(p);
 	trap_exit(p);
 }
@@ -2,6 +2,7 @@
 #include "syscall.h"
 
 #include "altc/string.h"
+#include "acct.h"
 #include "cap_fs.h"
 #include "cap_ipc.h"
 #include "cap_monitor.h"
@@ -13,63 +14,133 @@
 #include "csr.h"
 #include "drivers/time.h"
 #include "error.h"
+#include "fpu.h"
+#include "hpm.h"
 #include "kernel.h"
+#include "lockstat.h"
+#include "macro.h"
 #include "pmp.h"
 #include "preempt.h"
 #include "sched.h"
+#include "syshist.h"
+#include "trace.h"
 #include "trap.h"
 
 #include <stdbool.h>
-
-#define ARGS 8
-
-/** True if process p should ignore ERR_PREEMPTED for system call */
-static err_t validate_arguments(uint64_t call, const sys_args_t *args, const proc_t *p);
-static err_t sys_get_info(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_reg_read(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_reg_write(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_sync(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_cap_read(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_cap_move(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_cap_delete(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_cap_revoke(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_cap_derive(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_pmp_load(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_pmp_unload(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_suspend(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_resume(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_state_get(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_yield(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_reg_read(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_reg_write(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_cap_read(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_cap_move(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_pmp_load(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_pmp_unload(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_sock_send(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_sock_recv(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_sock_sendrecv(proc_t *p, const sys_args_t *args, uint64_t *ret);
-
-static err_t sys_path_read(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_mon_path_read(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_path_derive(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_read_file(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_write_file(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_create_dir(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_path_delete(proc_t *p, const sys_args_t *args, uint64_t *ret);
-static err_t sys_read_dir(proc_t *p, const sys_args_t *args, uint64_t *ret);
+#include <stddef.h>
+
+#ifndef S3K_SYSCALLS_MON
+#define S3K_SYSCALLS_MON 1
+#endif
+#ifndef S3K_SYSCALLS_IPC
+#define S3K_SYSCALLS_IPC 1
+#endif
+#ifndef S3K_SYSCALLS_FS
+#define S3K_SYSCALLS_FS 1
+#endif
+#ifndef S3K_SYSCALLS_SCHED
+#define S3K_SYSCALLS_SCHED 1
+#endif
+#ifndef S3K_SYSCALLS_STATS
+#define S3K_SYSCALLS_STATS 1
+#endif
+#define S3K_SYSCALLS_CORE 1
 
 typedef err_t (*sys_handler_t)(proc_t *, const sys_args_t *, uint64_t *);
 
-// Order of handlers must be in sync with the syscall_t enum
-sys_handler_t handlers[]
-    = {sys_get_info,	   sys_reg_read,      sys_reg_write,	sys_sync,	   sys_cap_read,
-       sys_cap_move,	   sys_cap_delete,    sys_cap_revoke,	sys_cap_derive,	   sys_pmp_load,
-       sys_pmp_unload,	   sys_mon_suspend,   sys_mon_resume,	sys_mon_state_get, sys_mon_yield,
-       sys_mon_reg_read,   sys_mon_reg_write, sys_mon_cap_read, sys_mon_cap_move,  sys_mon_pmp_load,
-       sys_mon_pmp_unload, sys_sock_send,     sys_sock_recv,	sys_sock_sendrecv, sys_path_read,
-       sys_mon_path_read,  sys_path_derive,   sys_read_file,	sys_write_file,	   sys_create_dir,
-       sys_path_delete,	   sys_read_dir};
+/** Location of an argument in sys_args_t, size 0 if none. */
+typedef struct {
+	uint8_t off;
+	uint8_t size;
+} sys_field_t;
+
+typedef enum {
+	SYS_ARG_NONE,
+	SYS_ARG_CIDX,	   // Capability index.
+	SYS_ARG_PID,	   // Process ID.
+	SYS_ARG_REG,	   // Register number.
+	SYS_ARG_PMP_SLOT,  // PMP slot.
+	SYS_ARG_TIME_SLOT, // Time slot.
+	SYS_ARG_HART,	   // Hart ID.
+	SYS_ARG_SYSCALL,   // System call number.
+	SYS_ARG_CAP,	   // Capability to derive.
+	SYS_ARG_PATH,	   // Path string, or NULL.
+	SYS_ARG_BUF,	   // Buffer in the process's PMP regions.
+} sys_arg_kind_t;
+
+typedef struct {
+	uint8_t kind;
+	sys_field_t field;
+	// Buffers: the length argument, if any, the required permissions and
+	// the size of the buffer, or of an element if it has a length.
+	sys_field_t len;
+	uint8_t perm;
+	uint32_t elem;
+} sys_arg_t;
+
+typedef enum {
+	SYS_LOCK_NONE,	// The handler locks what it needs.
+	SYS_LOCK_PROCS, // The caller and, if any, the process of pid.
+	SYS_LOCK_CTES,	// The entries, their derivation neighbours and parents.
+} sys_lock_kind_t;
+
+typedef struct {
+	uint8_t kind;
+	sys_field_t pid;
+	// SYS_LOCK_CTES: entries as process (none if the caller) and index.
+	struct {
+		sys_field_t pid, idx;
+	} ctes[3];
+} sys_lock_t;
+
+#define SYS_ARG_MAX 5
+
+typedef struct {
+	sys_handler_t handler; // NULL if compiled out.
+	bool multi;	       // May be batched by SYS_MULTICALL.
+	sys_lock_t lock;
+	sys_arg_t args[SYS_ARG_MAX];
+} sys_desc_t;
+
+#define FIELD(f) {offsetof(sys_args_t, f), sizeof(((sys_args_t *)0)->f)}
+#define NOARGS {SYS_ARG_NONE}
+#define ARG(kind, f) {SYS_ARG_##kind, FIELD(f)}
+#define BUF(f, perm_) {SYS_ARG_BUF, FIELD(f), .perm = perm_, .elem = sizeof(*((sys_args_t *)0)->f)}
+#define BUFN(f, n, elem_, perm_) {SYS_ARG_BUF, FIELD(f), FIELD(n), perm_, elem_}
+#define NOLOCK {SYS_LOCK_NONE}
+#define LOCK_SELF {SYS_LOCK_PROCS}
+#define LOCK_PROC(f) {SYS_LOCK_PROCS, FIELD(f)}
+#define LOCK_CTES(...) {SYS_LOCK_CTES, .ctes = {__VA_ARGS__}}
+#define CTE(pid, idx) {FIELD(pid), FIELD(idx)}
+#define OWN_CTE(idx) {{0}, FIELD(idx)}
+#define MULTI true
+#define SINGLE false
+
+#define X(NAME, name, ...) static err_t sys_##name(proc_t *p, const sys_args_t *args, uint64_t *ret);
+SYSCALLS(X)
+#undef X
+
+static const sys_desc_t descs[SYS_CNT] = {
+#define X(NAME, name, group, multi, lock, ...) \
+	[SYS_##NAME] = {S3K_SYSCALLS_##group ? sys_##name : NULL, multi, lock, {__VA_ARGS__}},
+    SYSCALLS(X)
+#undef X
+};
+
+static err_t validate_arguments(const sys_desc_t *desc, const sys_args_t *args, const proc_t *p);
+static bool lock_arguments(const sys_lock_t *lock, const sys_args_t *args, proc_t *p);
+
+static err_t dispatch(const sys_desc_t *desc, const sys_args_t *args, proc_t *p, uint64_t *ret)
+{
+	if (desc->lock.kind == SYS_LOCK_NONE)
+		return desc->handler(p, args, ret);
+	// Kernel locks fail on preemption.
+	if (!lock_arguments(&desc->lock, args, p))
+		return ERR_PREEMPTED;
+	err_t err = desc->handler(p, args, ret);
+	kernel_unlock(p);
+	return err;
+}
 
 void handle_syscall(proc_t *p)
 {
@@ -80,39 +151,24 @@ void handle_syscall(proc_t *p)
 	// Return value.
 	uint64_t ret = 0;
 
+	trace(TRACE_SYSCALL, p->pid, call);
+
 	// Check that the arguments of the system calls are valid.
-	err_t err = validate_arguments(call, args, p);
-	if (err)
+	const sys_desc_t *desc = call < SYS_CNT ? &descs[call] : NULL;
+	err_t err = ERR_INVALID_SYSCALL;
+	if (desc && desc->handler)
+		err = validate_arguments(desc, args, p);
+	if (err) {
+		trace(TRACE_SYSCALL_RET, p->pid, err);
 		goto fail_lbl;
+	}
 
 	if (preempt())
 		sched(p);
-	kernel_hook_sys_entry(p);
-
-	switch (call) {
-		/* System calls without initial lock */
-	case SYS_GET_INFO:
-	case SYS_REG_READ:
-	case SYS_REG_WRITE:
-	case SYS_SYNC:
-	case SYS_CAP_READ:
-	case SYS_CAP_REVOKE:
-		err = handlers[call](p, args, &ret);
-		break;
-	default:
-		/* System calls using an initial lock */
-		if (!kernel_lock(p)) {
-			/* Kernel lock fails on preemption. */
-			err = ERR_PREEMPTED;
-			break;
-		}
-		err = handlers[call](p, args, &ret);
-		kernel_unlock(p);
-		break;
-	}
-
-	/* Exit hook for instrumentation */
-	kernel_hook_sys_exit(p);
+	uint64_t start = syshist_now();
+	err = dispatch(desc, args, p, &ret);
+	syshist_record(call, start);
+	trace(TRACE_SYSCALL_RET, p->pid, err);
 
 	switch (err) {
 	case YIELD: { // Yield to another process.
@@ -121,13 +177,24 @@ void handle_syscall(proc_t *p)
 		proc_t *next = (proc_t *)ret;
 		if (next == NULL)
 			sched(p);
-		if (next != p)
+		if (next != p) {
+			fpu_release(p);
+			hpm_release(p);
+			acct_release(p, false);
 			proc_release(p);
+			fpu_dispatch(next);
+			hpm_enter(next);
+			acct_enter(next);
+		}
+		fpu_enter(next);
 		trap_exit(next);
 		UNREACHABLE();
 	}
-	case ERR_SUSPENDED:
 	case ERR_PREEMPTED:
+		// The arguments are rebuilt on retry, ret may report progress.
+		p->regs[REG_A0] = ret;
+		// fallthrough
+	case ERR_SUSPENDED:
 		p->regs[REG_PC] += 4;
 		p->regs[REG_T0] = err;
 		sched(p);
@@ -196,186 +263,126 @@ static bool valid_reg(reg_t reg)
 	return reg < REG_CNT;
 }
 
-err_t validate_arguments(uint64_t call, const sys_args_t *args, const proc_t *p)
+static bool valid_hart(hart_t hart)
 {
-	// Check the argument of the system call, if they are
-	// within bounds.
-	// Checks start from the first argument.
-	switch (call) {
-	case SYS_GET_INFO:
-	case SYS_SYNC:
-		return SUCCESS;
-
-	case SYS_REG_READ:
-	case SYS_REG_WRITE:
-		if (!valid_reg(args->reg.reg))
-			return ERR_INVALID_REGISTER;
-		return SUCCESS;
-
-	case SYS_CAP_READ:
-	case SYS_CAP_DELETE:
-	case SYS_CAP_REVOKE:
-		if (!valid_idx(args->cap.idx))
-			return ERR_INVALID_INDEX;
-		return SUCCESS;
-
-	case SYS_CAP_MOVE:
-		if (!valid_idx(args->cap.idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_idx(args->cap.dst_idx))
-			return ERR_INVALID_INDEX;
-		return SUCCESS;
-
-	case SYS_CAP_DERIVE:
-		if (!valid_idx(args->cap.idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_idx(args->cap.dst_idx))
-			return ERR_INVALID_INDEX;
-		if (!cap_is_valid(args->cap.cap))
-			return ERR_INVALID_DERIVATION;
-		return SUCCESS;
-
-	case SYS_PMP_LOAD:
-		if (!valid_idx(args->pmp.pmp_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_slot(args->pmp.pmp_slot))
-			return ERR_INVALID_SLOT;
-		return SUCCESS;
-
-	case SYS_PMP_UNLOAD:
-		if (!valid_idx(args->pmp.pmp_idx))
-			return ERR_INVALID_INDEX;
-		return SUCCESS;
-
-	case SYS_MON_SUSPEND:
-	case SYS_MON_RESUME:
-	case SYS_MON_STATE_GET:
-	case SYS_MON_YIELD:
-		if (!valid_idx(args->mon_state.mon_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_state.pid))
-			return ERR_INVALID_PID;
-		return SUCCESS;
+	// Unsigned, so harts below S3K_MIN_HART wrap around.
+	return (uint64_t)hart - S3K_MIN_HART < S3K_HART_CNT;
+}
 
-	case SYS_MON_REG_READ:
-	case SYS_MON_REG_WRITE:
-		if (!valid_idx(args->mon_reg.mon_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_reg.pid))
-			return ERR_INVALID_PID;
-		if (!valid_reg(args->mon_reg.reg))
-			return ERR_INVALID_REGISTER;
-		return SUCCESS;
+static uint64_t field_get(const sys_args_t *args, sys_field_t f)
+{
+	const void *a = (const uint8_t *)args + f.off;
+	switch (f.size) {
+	case 1:
+		return *(const uint8_t *)a;
+	case 2:
+		return *(const uint16_t *)a;
+	case 4:
+		return *(const uint32_t *)a;
+	default:
+		return *(const uint64_t *)a;
+	}
+}
 
-	case SYS_MON_CAP_READ:
-		if (!valid_idx(args->mon_cap.mon_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_cap.pid))
-			return ERR_INVALID_PID;
-		if (!valid_idx(args->mon_cap.idx))
-			return ERR_INVALID_INDEX;
+static err_t validate_argument(const sys_arg_t *arg, const sys_args_t *args, const proc_t *p)
+{
+	uint64_t val = field_get(args, arg->field);
+	switch (arg->kind) {
+	case SYS_ARG_CIDX:
+		return valid_idx(val) ? SUCCESS : ERR_INVALID_INDEX;
+	case SYS_ARG_PID:
+		return valid_pid(val) ? SUCCESS : ERR_INVALID_PID;
+	case SYS_ARG_REG:
+		return valid_reg(val) ? SUCCESS : ERR_INVALID_REGISTER;
+	case SYS_ARG_PMP_SLOT:
+		return valid_slot(val) ? SUCCESS : ERR_INVALID_SLOT;
+	case SYS_ARG_TIME_SLOT:
+		return val < S3K_SLOT_CNT ? SUCCESS : ERR_INVALID_SLOT;
+	case SYS_ARG_HART:
+		return valid_hart(val) ? SUCCESS : ERR_INVALID_HART;
+	case SYS_ARG_SYSCALL:
+		return val < SYS_CNT ? SUCCESS : ERR_INVALID_SYSCALL;
+	case SYS_ARG_CAP:
+		return cap_is_valid(*(const cap_t *)((const uint8_t *)args + arg->field.off))
+			   ? SUCCESS
+			   : ERR_INVALID_DERIVATION;
+	case SYS_ARG_PATH: {
+		const char *path = (const char *)val;
+		if (path == NULL)
+			return SUCCESS;
+		size_t s_len = alt_strnlen_s(path, S3K_MAX_PATH_LEN);
+		if (s_len == 0 || s_len == S3K_MAX_PATH_LEN)
+			return ERR_INVALID_PATH;
+		if (!valid_addr_range(p, path, s_len + 1 /* Include terminator */, MEM_R))
+			return ERR_INVALID_MEM_ADDRESS;
 		return SUCCESS;
-
-	case SYS_MON_CAP_MOVE:
-		if (!valid_idx(args->mon_cap.mon_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_cap.pid))
-			return ERR_INVALID_PID;
-		if (!valid_idx(args->mon_cap.idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_cap.dst_pid))
-			return ERR_INVALID_PID;
-		if (!valid_idx(args->mon_cap.dst_idx))
-			return ERR_INVALID_INDEX;
+	}
+	case SYS_ARG_BUF: {
+		uint64_t n = arg->len.size ? field_get(args, arg->len) : 1;
+		// The size is checked by valid_addr_range, avoid overflowing it.
+		if (n > UINT32_MAX / arg->elem
+		    || !valid_addr_range(p, (const void *)val, n * arg->elem, arg->perm))
+			return ERR_INVALID_MEM_ADDRESS;
 		return SUCCESS;
-
-	case SYS_MON_PMP_LOAD:
-		if (!valid_idx(args->mon_pmp.mon_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_pmp.pid))
-			return ERR_INVALID_PID;
-		if (!valid_idx(args->mon_pmp.pmp_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_slot(args->mon_pmp.pmp_slot))
-			return ERR_INVALID_SLOT;
+	}
+	default:
 		return SUCCESS;
+	}
+}
 
-	case SYS_MON_PMP_UNLOAD:
-		if (!valid_idx(args->mon_pmp.mon_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_pmp.pid))
-			return ERR_INVALID_PID;
-		if (!valid_idx(args->mon_pmp.pmp_idx))
-			return ERR_INVALID_INDEX;
-		return SUCCESS;
+err_t validate_arguments(const sys_desc_t *desc, const sys_args_t *args, const proc_t *p)
+{
+	// Checks start from the first argument.
+	for (int i = 0; i < SYS_ARG_MAX && desc->args[i].kind != SYS_ARG_NONE; i++) {
+		err_t err = validate_argument(&desc->args[i], args, p);
+		if (err)
+			return err;
+	}
+	return SUCCESS;
+}
 
-	case SYS_SOCK_SEND:
-	case SYS_SOCK_RECV:
-	case SYS_SOCK_SENDRECV:
-		if (!valid_idx(args->sock.sock_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_idx(args->sock.cap_idx))
-			return ERR_INVALID_INDEX;
-		return SUCCESS;
+static bool lock_procs(proc_t *p, uint64_t pid)
+{
+	uint64_t pids[] = {p->pid, pid};
+	return kernel_lock_procs(p, ARRAY_SIZE(pids), pids);
+}
 
-	case SYS_READ_FILE:
-	case SYS_WRITE_FILE:
-		if (!valid_idx(args->file.idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_addr_range(p, args->file.buf, args->file.buf_size, MEM_RW))
-			return ERR_INVALID_MEM_ADDRESS;
-		if (!valid_addr_range(p, args->file.bytes_result, sizeof(*args->file.bytes_result),
-				      MEM_RW))
-			return ERR_INVALID_MEM_ADDRESS;
-		return SUCCESS;
+bool lock_arguments(const sys_lock_t *lock, const sys_args_t *args, proc_t *p)
+{
+	// Lock the processes whose capabilities or state the system call
+	// reads or modifies. Calls changing the derivation tree also lock the
+	// neighbours and the parents of the entries.
+	if (lock->kind == SYS_LOCK_PROCS)
+		return lock_procs(p, lock->pid.size ? field_get(args, lock->pid) : p->pid);
 
-	case SYS_PATH_READ:
-		if (!valid_idx(args->read_path.idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_addr_range(p, args->read_path.buf, args->read_path.n, MEM_RW))
-			return ERR_INVALID_MEM_ADDRESS;
-		return SUCCESS;
-	case SYS_MON_PATH_READ:
-		if (!valid_idx(args->mon_read_path.mon_idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_pid(args->mon_read_path.pid))
-			return ERR_INVALID_PID;
-		if (!valid_idx(args->mon_read_path.idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_addr_range(p, args->mon_read_path.buf, args->mon_read_path.n, MEM_RW))
-			return ERR_INVALID_MEM_ADDRESS;
-		return SUCCESS;
-	case SYS_PATH_DELETE:
-		if (!valid_idx(args->delete_path.idx))
-			return ERR_INVALID_INDEX;
-		return SUCCESS;
-	case SYS_PATH_DERIVE:
-		if (!valid_idx(args->path.idx))
-			return ERR_INVALID_INDEX;
-		if (!valid_idx(args->path.dst_idx))
-			return ERR_INVALID_INDEX;
-		if (args->path.path != NULL) {
-			size_t s_len = alt_strnlen_s(args->path.path, S3K_MAX_PATH_LEN);
-			if (s_len == 0 || s_len == S3K_MAX_PATH_LEN)
-				return ERR_INVALID_PATH;
-			if (!valid_addr_range(p, args->path.path,
-					      s_len + 1 /* Include terminator */, MEM_R))
-				return ERR_INVALID_MEM_ADDRESS;
-		}
-		return SUCCESS;
-	case SYS_CREATE_DIR:
-		if (!valid_idx(args->create_dir.idx))
-			return ERR_INVALID_INDEX;
-		return SUCCESS;
-	case SYS_READ_DIR:
-		if (!valid_idx(args->read_dir.directory))
-			return ERR_INVALID_INDEX;
-		if (!valid_addr_range(p, args->read_dir.out, sizeof(*args->read_dir.out), MEM_RW))
-			return ERR_INVALID_MEM_ADDRESS;
-		return SUCCESS;
-	default:
-		return ERR_INVALID_SYSCALL;
+	cte_t ctes[ARRAY_SIZE(lock->ctes)];
+	uint64_t n = 0;
+	for (; n < ARRAY_SIZE(lock->ctes) && lock->ctes[n].idx.size; n++) {
+		uint64_t pid = lock->ctes[n].pid.size ? field_get(args, lock->ctes[n].pid) : p->pid;
+		ctes[n] = ctable_get(pid, field_get(args, lock->ctes[n].idx));
 	}
+	return kernel_lock_ctes(p, n, ctes);
+}
+
+/// Get info selectors that reset statistics of all processes, they require a
+/// root monitor, as MON_SYSHIST_READ.
+static err_t get_info_reset(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	if (!valid_idx(args->get_info.mon_idx))
+		return ERR_INVALID_INDEX;
+	uint64_t pid = p->pid;
+	if (!kernel_lock_procs(p, 1, &pid))
+		return ERR_PREEMPTED;
+	cte_t mon = ctable_get(p->pid, args->get_info.mon_idx);
+	err_t err;
+	if (args->get_info.info == 4)
+		err = cap_monitor_wcet_reset(mon, ret);
+	else
+		err = cap_monitor_lockstat_reset(mon, args->get_info.hart,
+						 args->get_info.lock,
+						 args->get_info.stat, ret);
+	kernel_unlock(p);
+	return err;
 }
 
 err_t sys_get_info(proc_t *p, const sys_args_t *args, uint64_t *ret)
@@ -391,12 +398,19 @@ err_t sys_get_info(proc_t *p, const sys_args_t *args, uint64_t *ret)
 		*ret = timeout_get(csrr_mhartid());
 		break;
 	case 3:
-		*ret = kernel_wcet();
+		*ret = syshist_wcet(false);
 		break;
 	case 4:
-		*ret = kernel_wcet();
-		kernel_wcet_reset();
+		return get_info_reset(p, args, ret);
+	case 5:
+		*ret = sched_idle_time(args->get_info.hart);
+		break;
+	case 6:
+		*ret = lockstat_get(args->get_info.hart, args->get_info.lock,
+				    args->get_info.stat, false);
 		break;
+	case 7:
+		return get_info_reset(p, args, ret);
 	default:
 		*ret = 0;
 	}
@@ -405,13 +419,21 @@ err_t sys_get_info(proc_t *p, const sys_args_t *args, uint64_t *ret)
 
 err_t sys_reg_read(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
+	if (hpm_is_reg(args->reg.reg))
+		hpm_sync(p);
 	*ret = p->regs[args->reg.reg];
 	return SUCCESS;
 }
 
 err_t sys_reg_write(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
+	bool hpm = hpm_is_reg(args->reg.reg);
+	// Count up to the write, then count from the written value.
+	if (hpm)
+		hpm_release(p);
 	p->regs[args->reg.reg] = args->reg.val;
+	if (hpm)
+		hpm_enter(p);
 	return SUCCESS;
 }
 
@@ -442,32 +464,64 @@ err_t sys_cap_delete(proc_t *p, const sys_args_t *args, uint64_t *ret)
 	return cap_delete(c);
 }
 
+// Reclaim children of c while their processes are locked, until preempted.
+// Returns false if c has no more children.
+static bool revoke_batch(cte_t c)
+{
+	cap_t cap = cte_cap(c);
+	time_slot_t from = cap.time.end;
+	bool more = true;
+	do {
+		cte_t next = cte_child(c);
+		if (!next) {
+			more = false;
+			break;
+		}
+		cap_t ncap = cte_cap(next);
+		// Paths have no range to compare, only the derivation tree
+		// relates them.
+		KASSERT(cap.type == CAPTY_PATH ? ncap.type == CAPTY_PATH
+					       : cap_is_revokable(cap, ncap));
+		// Delete (next, ncap), take its resource, and update (c, cap)
+		cap_reclaim(c, cap, next, ncap);
+		if (ncap.type == CAPTY_TIME && ncap.time.mrk < from)
+			from = ncap.time.mrk;
+		cap = cte_cap(c);
+		// The new child's process is that of the old child's neighbour,
+		// continue while the lock of its neighbour is held too.
+	} while (!preempt() && kernel_holds_proc(cte_pid(cte_next(cte_next(c)))));
+	if (cap.type == CAPTY_TIME && from < cap.time.end)
+		cap_reclaim_sched(c, from);
+	return more;
+}
+
 err_t sys_cap_revoke(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
+	// The derivation tree is the cursor: children reclaimed before a
+	// preemption are gone, a retry continues with the rest.
 	cte_t c = ctable_get(p->pid, args->cap.idx);
+	cte_t ctes[] = {c, NULL};
 	while (1) {
-		cap_t cap = cte_cap(c);
-		cte_t next = cte_next(c);
-		cap_t ncap = cte_cap(next);
-		if (!cap.type)
+		// Lock c, its first child and the child's neighbours. Locking
+		// validates that next still follows c.
+		ctes[1] = cte_next(c);
+		if (!kernel_lock_ctes(p, ARRAY_SIZE(ctes), ctes))
+			return ERR_PREEMPTED;
+		if (cte_next(c) != ctes[1]) {
+			kernel_unlock(p);
+			continue;
+		}
+		if (!cte_cap(c).type) {
+			kernel_unlock(p);
 			return ERR_EMPTY;
-		// If ncap can not be revoked, we have no more children.
-		if (!cap_is_revokable(cap, ncap))
+		}
+		if (!revoke_batch(c))
 			break;
-		if (!kernel_lock(p))
-			return ERR_PREEMPTED;
-		// Delete (next, ncap), take its resource, and update (c, cap)
-		// The delete may fail due to interference.
-		// Checks cte_next(c) == next && cte_cap == ncap before
-		// deleting.
-		cap_reclaim(c, cap, next, ncap);
 		kernel_unlock(p);
 	}
 
 	// We should reach here if we have no more children.
-	if (!kernel_lock(p))
-		return ERR_PREEMPTED;
-	// Reset the capability at c.
+	// Reset the capability at c, still holding the locks.
 	err_t err = cap_reset(c);
 	kernel_unlock(p);
 	return err;
@@ -557,36 +611,76 @@ err_t sys_mon_pmp_unload(proc_t *p, const sys_args_t *args, uint64_t *ret)
 	return cap_monitor_pmp_unload(mon, pmp);
 }
 
+// Lock the socket, the sent capability and the capability buffers of the
+// receiver and of p, if used. The receiver is guessed before taking the locks
+// and checked again by cap_sock_send().
+static bool lock_sock(proc_t *p, cte_t sock, ipc_msg_t *msg, bool recv)
+{
+	cte_t ctes[KERNEL_CTE_MAX];
+	while (1) {
+		uint64_t n = 0;
+		cap_t sock_cap = cte_cap(sock);
+		msg->recv = NULL;
+		ctes[n++] = sock;
+		if (msg->send_cap) {
+			msg->recv = cap_sock_peer(sock_cap);
+			ctes[n++] = msg->src_buf;
+			if (msg->recv)
+				ctes[n++] = msg->recv->cap_buf;
+		}
+		if (recv)
+			ctes[n++] = p->cap_buf;
+		if (!kernel_lock_ctes(p, n, ctes))
+			return false;
+		if (cte_cap(sock).raw == sock_cap.raw)
+			return true;
+		kernel_unlock(p);
+	}
+}
+
 err_t sys_sock_send(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t sock = ctable_get(p->pid, args->sock.sock_idx);
-	const ipc_msg_t msg = {
+	ipc_msg_t msg = {
 	    .src_buf = ctable_get(p->pid, args->sock.cap_idx),
 	    .send_cap = args->sock.send_cap,
 	    .data
 	    = {args->sock.data[0], args->sock.data[1], args->sock.data[2], args->sock.data[3]},
 	};
-	return cap_sock_send(sock, &msg, (proc_t **)ret);
+	if (!lock_sock(p, sock, &msg, false))
+		return ERR_PREEMPTED;
+	err_t err = cap_sock_send(sock, &msg, (proc_t **)ret);
+	kernel_unlock(p);
+	return err;
 }
 
 err_t sys_sock_recv(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t sock = ctable_get(p->pid, args->sock.sock_idx);
+	ipc_msg_t msg = {.send_cap = false};
 	p->cap_buf = ctable_get(p->pid, args->sock.cap_idx);
-	return cap_sock_recv(sock);
+	if (!lock_sock(p, sock, &msg, true))
+		return ERR_PREEMPTED;
+	err_t err = cap_sock_recv(sock);
+	kernel_unlock(p);
+	return err;
 }
 
 err_t sys_sock_sendrecv(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t sock = ctable_get(p->pid, args->sock.sock_idx);
 	p->cap_buf = ctable_get(p->pid, args->sock.cap_idx);
-	const ipc_msg_t msg = {
+	ipc_msg_t msg = {
 	    .src_buf = ctable_get(p->pid, args->sock.cap_idx),
 	    .send_cap = args->sock.send_cap,
 	    .data
 	    = {args->sock.data[0], args->sock.data[1], args->sock.data[2], args->sock.data[3]},
 	};
-	return cap_sock_sendrecv(sock, &msg, (proc_t **)ret);
+	if (!lock_sock(p, sock, &msg, true))
+		return ERR_PREEMPTED;
+	err_t err = cap_sock_sendrecv(sock, &msg, (proc_t **)ret);
+	kernel_unlock(p);
+	return err;
 }
 
 err_t sys_path_read(proc_t *p, const sys_args_t *args, uint64_t *ret)
@@ -612,6 +706,8 @@ err_t sys_path_derive(proc_t *p, const sys_args_t *args, uint64_t *ret)
 err_t sys_read_file(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t file = ctable_get(p->pid, args->file.idx);
+	if (!kernel_lock_fs(p))
+		return ERR_PREEMPTED;
 	return read_file(cte_cap(file), args->file.offset, args->file.buf, args->file.buf_size,
 			 args->file.bytes_result);
 }
@@ -619,6 +715,8 @@ err_t sys_read_file(proc_t *p, const sys_args_t *args, uint64_t *ret)
 err_t sys_write_file(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t file = ctable_get(p->pid, args->file.idx);
+	if (!kernel_lock_fs(p))
+		return ERR_PREEMPTED;
 	return write_file(cte_cap(file), args->file.offset, args->file.buf, args->file.buf_size,
 			  args->file.bytes_result);
 }
@@ -626,17 +724,163 @@ err_t sys_write_file(proc_t *p, const sys_args_t *args, uint64_t *ret)
 err_t sys_create_dir(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t path = ctable_get(p->pid, args->create_dir.idx);
+	if (!kernel_lock_fs(p))
+		return ERR_PREEMPTED;
 	return create_dir(cte_cap(path), args->create_dir.ensure_create);
 }
 
 err_t sys_read_dir(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t path = ctable_get(p->pid, args->read_dir.directory);
+	if (!kernel_lock_fs(p))
+		return ERR_PREEMPTED;
 	return read_dir(cte_cap(path), args->read_dir.dir_entry_idx, args->read_dir.out);
 }
 
 err_t sys_path_delete(proc_t *p, const sys_args_t *args, uint64_t *ret)
 {
 	cte_t path = ctable_get(p->pid, args->delete_path.idx);
+	if (!kernel_lock_fs(p))
+		return ERR_PREEMPTED;
 	return path_delete(cte_cap(path));
 }
+
+err_t sys_mon_slack_set(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t mon = ctable_get(p->pid, args->mon_slack.mon_idx);
+	return cap_monitor_slack_set(mon, args->mon_slack.pid, args->mon_slack.hart,
+				     args->mon_slack.enable);
+}
+
+err_t sys_sched_stage(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t c = ctable_get(p->pid, args->sched.idx);
+	return cap_time_stage(c);
+}
+
+err_t sys_sched_commit(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t c = ctable_get(p->pid, args->sched.idx);
+	return cap_time_commit(c, args->sched.slot);
+}
+
+err_t sys_mon_syshist_read(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t mon = ctable_get(p->pid, args->mon_syshist.mon_idx);
+	return cap_monitor_syshist_read(mon, args->mon_syshist.hart, args->mon_syshist.call,
+					args->mon_syshist.hist, args->mon_syshist.reset);
+}
+
+err_t sys_mon_acct_read(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t mon = ctable_get(p->pid, args->mon_acct.mon_idx);
+	return cap_monitor_acct_read(mon, args->mon_acct.pid, args->mon_acct.acct);
+}
+
+err_t sys_mon_trace_read(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t mon = ctable_get(p->pid, args->mon_trace.mon_idx);
+	return cap_monitor_trace_read(mon, args->mon_trace.hart, args->mon_trace.buf,
+				      args->mon_trace.n, ret);
+}
+
+err_t sys_multicall(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	// Run the operations in order, stopping at the first that fails or
+	// on preemption. ret is the number of completed operations, so the
+	// caller can resume after them.
+	for (uint64_t i = 0; i < args->multicall.n; i++) {
+		// Copy the operation, it may change in user memory.
+		multicall_op_t op = args->multicall.ops[i];
+		*ret = i;
+		if (i > 0 && preempt())
+			return ERR_PREEMPTED;
+		const sys_desc_t *desc = op.call < SYS_CNT ? &descs[op.call] : NULL;
+		if (!desc || !desc->multi || !desc->handler)
+			return ERR_INVALID_SYSCALL;
+		err_t err = validate_arguments(desc, &op.args, p);
+		if (!err) {
+			uint64_t op_ret = 0;
+			err = dispatch(desc, &op.args, p, &op_ret);
+		}
+		if (err)
+			return err;
+	}
+	*ret = args->multicall.n;
+	return SUCCESS;
+}
+
+err_t sys_cap_read_range(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	return cap_read_range(p->pid, args->cap_range.idx, args->cap_range.n,
+			      args->cap_range.buf);
+}
+
+err_t sys_mon_cap_read_range(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t mon = ctable_get(p->pid, args->mon_cap_range.mon_idx);
+	return cap_monitor_cap_read_range(mon, args->mon_cap_range.pid, args->mon_cap_range.idx,
+					  args->mon_cap_range.n, args->mon_cap_range.buf);
+}
+
+err_t sys_cap_find(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	// Unknown types have no capabilities.
+	if (args->cap_find.type > CAPTY_PATH)
+		return ERR_NOT_FOUND;
+	*ret = ctable_find(p->pid, args->cap_find.idx, args->cap_find.type, args->cap_find.mask,
+			   args->cap_find.val);
+	return *ret < S3K_CAP_CNT ? SUCCESS : ERR_NOT_FOUND;
+}
+
+err_t sys_cap_parent(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t c = ctable_get(p->pid, args->cap.idx);
+	if (cte_is_empty(c))
+		return ERR_EMPTY;
+	// Only parents in the caller's own table are revealed.
+	cte_t parent = cte_parent(c);
+	if (!parent || cte_pid(parent) != p->pid)
+		return ERR_NOT_FOUND;
+	*ret = cte_idx(parent);
+	return SUCCESS;
+}
+
+err_t sys_cap_descendants(proc_t *p, const sys_args_t *args, uint64_t *ret)
+{
+	cte_t c = ctable_get(p->pid, args->cap.idx);
+	bool guess[S3K_PROC_CNT] = {0};
+
+	// Guess the owners of the subtree by a walk without the locks, then
+	// lock them and walk again. Retry if the walk reaches another process,
+	// the guess only grows so this ends.
+	guess[p->pid] = true;
+	cte_descendants(c, guess);
+	while (1) {
+		uint64_t pids[S3K_PROC_CNT], n = 0;
+		for (uint64_t i = 0; i < S3K_PROC_CNT; i++) {
+			if (guess[i])
+				pids[n++] = i;
+		}
+		if (!kernel_lock_procs(p, n, pids))
+			return ERR_PREEMPTED;
+
+		bool owners[S3K_PROC_CNT] = {0};
+		err_t err = SUCCESS;
+		if (cte_is_empty(c))
+			err = ERR_EMPTY;
+		else
+			*ret = cte_descendants(c, owners);
+		kernel_unlock(p);
+
+		bool stable = true;
+		for (uint64_t i = 0; i < S3K_PROC_CNT; i++) {
+			if (owners[i] && !guess[i]) {
+				guess[i] = true;
+				stable = false;
+			}
+		}
+		if (stable)
+			return err;
+	}
+}
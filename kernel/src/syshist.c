@@ -0,0 +1,59 @@
+#include "syshist.h"
+
+#include "altc/string.h"
+#include "csr.h"
+#include "syscall.h"
+
+#ifdef INSTRUMENT
+// Only the hart itself records into its histograms, a concurrent read or
+// reset from another hart may see or lose a partial sample.
+static syshist_t hists[S3K_HART_CNT][SYS_CNT];
+static uint64_t wcet;
+
+uint64_t syshist_now(void)
+{
+	return csrr_mcycle();
+}
+
+void syshist_record(uint64_t call, uint64_t start)
+{
+	uint64_t cycles = csrr_mcycle() - start;
+	syshist_t *h = &hists[csrr_mhartid() - S3K_MIN_HART][call];
+	uint64_t log2 = 63 - __builtin_clzll(cycles | 1);
+	uint64_t bin = log2 > SYSHIST_SHIFT ? log2 - SYSHIST_SHIFT : 0;
+	if (bin >= SYSHIST_BINS)
+		bin = SYSHIST_BINS - 1;
+	if (h->count == 0 || cycles < h->min)
+		h->min = cycles;
+	if (cycles > h->max)
+		h->max = cycles;
+	h->count++;
+	h->sum += cycles;
+	h->bins[bin]++;
+	__asm__ volatile("amomax.du x0,%0,(%1)" ::"r"(cycles), "r"(&wcet));
+}
+#endif
+
+void syshist_read(uint64_t hartid, uint64_t call, syshist_t *hist,
+		  bool reset)
+{
+#ifdef INSTRUMENT
+	syshist_t *h = &hists[hartid - S3K_MIN_HART][call];
+	memcpy(hist, h, sizeof(*h));
+	if (reset)
+		memset(h, 0, sizeof(*h));
+#else
+	memset(hist, 0, sizeof(*hist));
+#endif
+}
+
+uint64_t syshist_wcet(bool reset)
+{
+#ifdef INSTRUMENT
+	if (reset)
+		return __atomic_exchange_n(&wcet, 0, __ATOMIC_RELAXED);
+	return __atomic_load_n(&wcet, __ATOMIC_RELAXED);
+#else
+	return 0;
+#endif
+}
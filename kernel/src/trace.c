@@ -0,0 +1,76 @@
+#include "trace.h"
+
+#include "altc/string.h"
+#include "csr.h"
+#include "drivers/time.h"
+#include "macro.h"
+
+#include <stdbool.h>
+
+#ifdef S3K_TRACE
+typedef struct {
+	uint64_t head; // Records written, only the hart itself writes.
+	uint64_t tail; // Records drained, drainers advance it with a CAS.
+	trace_rec_t recs[S3K_TRACE_LEN];
+} __attribute__((aligned(CACHE_LINE))) ring_t;
+
+static ring_t rings[S3K_HART_CNT];
+
+void trace(trace_event_t event, uint64_t pid, uint64_t arg)
+{
+	uint64_t hartid = csrr_mhartid();
+	ring_t *r = &rings[hartid - S3K_MIN_HART];
+	uint64_t head = r->head;
+	trace_rec_t *rec = &r->recs[head % S3K_TRACE_LEN];
+	rec->time = time_get();
+	rec->seq = head;
+	rec->pid = pid;
+	rec->event = event;
+	rec->hart = hartid;
+	rec->arg = arg;
+	__atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+	// As on a seqlock writer, head must be visible before the next
+	// record's data, else a reader could accept that torn record.
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+uint64_t trace_read(uint64_t hart, trace_rec_t *buf, uint64_t n)
+{
+	ring_t *r = &rings[hart - S3K_MIN_HART];
+	uint64_t prev = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+	uint64_t tail, cnt;
+
+	do {
+		uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		tail = prev;
+
+		// Skip the overwritten records.
+		if (head - tail > S3K_TRACE_LEN)
+			tail = head - S3K_TRACE_LEN;
+		cnt = head - tail;
+		if (cnt > n)
+			cnt = n;
+		for (uint64_t i = 0; i < cnt; i++)
+			buf[i] = r->recs[(tail + i) % S3K_TRACE_LEN];
+
+		// The hart may have overwritten the oldest records during the
+		// copy, the record at head is written before head is
+		// incremented.
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		uint64_t first = __atomic_load_n(&r->head, __ATOMIC_RELAXED)
+				 + 1 - S3K_TRACE_LEN;
+		if ((int64_t)(first - tail) > 0) {
+			uint64_t torn = first - tail;
+			if (torn > cnt)
+				torn = cnt;
+			memmove(buf, buf + torn, (cnt - torn) * sizeof(*buf));
+			tail += torn;
+			cnt -= torn;
+		}
+		// Another drainer took these records first, copy again.
+	} while (!__atomic_compare_exchange_n(&r->tail, &prev, tail + cnt,
+					      false, __ATOMIC_RELAXED,
+					      __ATOMIC_RELAXED));
+	return cnt;
+}
+#endif
@@ -31,7 +31,7 @@ void main(void)
 			ppp_send(s, 6);
 			continue;
 		}
-		alt_printf("{wcet:0x%X}", s3k_get_wcet(true));
+		alt_printf("{wcet:0x%X}", s3k_get_wcet());
 		ppp_send(buf, reply.data[0]);
 	}
 }
@@ -28,6 +28,42 @@
 // Scheduler time
 #define S3K_SCHED_TIME (S3K_SLOT_LEN / 10)
 
+// Variable slot lengths in ticks, replaces S3K_SLOT_LEN. The period (major
+// frame) is S3K_MINOR_CNT minor frames. S3K_MINOR_SLOT_LENS lists the slots
+// of one minor frame, repeated in every minor frame, or all S3K_SLOT_CNT
+// slots of the period, so each minor frame has its own layout. Every slot
+// must be at least S3K_SCHED_TIME long. Time capabilities still index the
+// S3K_SLOT_CNT slots of the period.
+// #define S3K_MINOR_CNT 8
+// #define S3K_MINOR_SLOT_LENS { 1000, 1000, 500, 5500 }
+
+// Lazy floating-point context switching (F/D extensions), for processes
+// compiled with floating point, see kernel/inc/fpu.h.
+// #define S3K_FPU
+
+// Per-process performance counters: cycles, instructions retired and the
+// first S3K_HPM_CNT (at most 4) of mhpmcounter3-6, see kernel/inc/hpm.h.
+// #define S3K_HPM_CNT 2
+// Event bits a process may select, see kernel/inc/hpm.h.
+// #define S3K_HPM_EVENT_MASK ((1ull << 56) - 1)
+
+// Kernel event trace, S3K_TRACE_LEN records per hart, see kernel/inc/trace.h.
+// #define S3K_TRACE
+// #define S3K_TRACE_LEN 256
+
+// Read-only mirrors of the capability tables for reading capabilities
+// without a trap, see kernel/inc/cap_mirror.h and s3k_cap_mirror_set().
+// #define S3K_CAP_MIRROR
+
+// System call groups, set to 0 to compile the group's calls out of the
+// kernel, see SYSCALLS in kernel/inc/syscall.h. Compiled out calls fail
+// with ERR_INVALID_SYSCALL.
+// #define S3K_SYSCALLS_MON 0
+// #define S3K_SYSCALLS_IPC 0
+// #define S3K_SYSCALLS_FS 0
+// #define S3K_SYSCALLS_SCHED 0
+// #define S3K_SYSCALLS_STATS 0
+
 // If debugging, comment
 // #define NDEBUG
 #define VERBOSE 2
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "../churn.h"
+
+// See plat_conf.h
+#define BOOT_PMP 0
+#define RAM_MEM 1
+#define UART_MEM 2
+#define TIME_MEM 3
+#define HART0_TIME 4
+#define HART1_TIME 5
+#define HART2_TIME 6
+#define HART3_TIME 7
+#define MONITOR 8
+#define CHANNEL 9
+
+#define APP1_PID 1
+#define APP1_BASE 0x80020000
+
+// Free slots of app0.
+#define UART_PMP 10
+#define SHARED_PMP 11
+#define TMP 12
+#define HART1_CHURN 13
+
+s3k_err_t setup_uart(uint64_t uart_idx)
+{
+	uint64_t uart_addr = s3k_napot_encode(UART0_BASE_ADDR, 0x8);
+	s3k_err_t err = s3k_cap_derive(UART_MEM, uart_idx,
+				       s3k_mk_pmp(uart_addr, S3K_MEM_RW));
+	if (!err)
+		err = s3k_pmp_load(uart_idx, 1);
+	s3k_sync_mem();
+	return err;
+}
+
+s3k_err_t setup_shared(void)
+{
+	uint64_t shared_addr = s3k_napot_encode(SHARED_BASE, SHARED_SIZE);
+	s3k_err_t err = s3k_cap_derive(RAM_MEM, SHARED_PMP,
+				       s3k_mk_pmp(shared_addr, S3K_MEM_RW));
+	if (!err)
+		err = s3k_pmp_load(SHARED_PMP, 2);
+	if (err)
+		return err;
+	s3k_sync_mem();
+	SHARED->phase = PHASE_IDLE;
+	return 0;
+}
+
+s3k_err_t setup_time(void)
+{
+	s3k_err_t err = 0;
+
+	// app1 gets the first SLICE_LEN slots of every stride, the rest of
+	// the stride is deleted so hart 1 idles there.
+	for (uint64_t i = 0; i < SLICE_CNT && !err; i++) {
+		uint64_t bgn = i * SLICE_STRIDE;
+		err = s3k_cap_derive(HART1_TIME, TMP,
+				     s3k_mk_time(CHURN_HART, bgn,
+						 bgn + SLICE_LEN));
+		if (!err)
+			err = s3k_mon_cap_move(MONITOR, 0, TMP, APP1_PID,
+					       APP_TIME + i);
+		if (err || i == SLICE_CNT - 1)
+			break;
+		err = s3k_cap_derive(HART1_TIME, TMP,
+				     s3k_mk_time(CHURN_HART, bgn + SLICE_LEN,
+						 bgn + SLICE_STRIDE));
+		if (!err)
+			err = s3k_cap_delete(TMP);
+	}
+
+	// The last gap is churned, a revoke of it must not reach app1.
+	if (!err)
+		err = s3k_cap_derive(
+		    HART1_TIME, HART1_CHURN,
+		    s3k_mk_time(CHURN_HART,
+				(SLICE_CNT - 1) * SLICE_STRIDE + SLICE_LEN,
+				S3K_SLOT_CNT));
+	return err;
+}
+
+s3k_err_t setup_app1(void)
+{
+	uint64_t app1_addr = s3k_napot_encode(APP1_BASE, 0x10000);
+	uint64_t shared_addr = s3k_napot_encode(SHARED_BASE, SHARED_SIZE);
+	s3k_err_t err;
+
+	// Main memory
+	err = s3k_cap_derive(RAM_MEM, TMP, s3k_mk_pmp(app1_addr, S3K_MEM_RWX));
+	if (!err)
+		err = s3k_mon_cap_move(MONITOR, 0, TMP, APP1_PID, APP_MEM_PMP);
+	if (!err)
+		err = s3k_mon_pmp_load(MONITOR, APP1_PID, APP_MEM_PMP, 0);
+
+	// Results page
+	if (!err)
+		err = s3k_cap_derive(RAM_MEM, TMP,
+				     s3k_mk_pmp(shared_addr, S3K_MEM_RW));
+	if (!err)
+		err = s3k_mon_cap_move(MONITOR, 0, TMP, APP1_PID,
+				       APP_SHARED_PMP);
+	if (!err)
+		err = s3k_mon_pmp_load(MONITOR, APP1_PID, APP_SHARED_PMP, 1);
+
+	if (!err)
+		err = setup_time();
+	if (!err)
+		err = s3k_mon_reg_write(MONITOR, APP1_PID, S3K_REG_PC,
+					APP1_BASE);
+	return err;
+}
+
+/// Derive a one-slot time capability from time and reclaim it.
+static s3k_err_t churn_one(s3k_cidx_t time)
+{
+	s3k_cap_t cap;
+	s3k_err_t err = s3k_cap_read(time, &cap);
+	if (!err)
+		err = s3k_cap_derive(time, TMP,
+				     s3k_mk_time(cap.time.hart, cap.time.mrk,
+						 cap.time.mrk + 1));
+	if (!err)
+		err = s3k_cap_revoke(time);
+	return err;
+}
+
+static s3k_err_t churn(uint64_t *ops)
+{
+	const s3k_cidx_t times[] = {HART1_CHURN, HART2_TIME, HART3_TIME};
+	s3k_err_t err = 0;
+
+	*ops = 0;
+	while (!err
+	       && __atomic_load_n(&SHARED->phase, __ATOMIC_ACQUIRE)
+		      == PHASE_CHURN) {
+		err = churn_one(times[*ops % 3]);
+		if (!err)
+			(*ops)++;
+	}
+	return err;
+}
+
+static void print_result(const char *name, volatile result_t *res)
+{
+	alt_printf("%s: p50=%d p90=%d p99=%d max=%d\n", name, res->p50,
+		   res->p90, res->p99, res->max);
+}
+
+int main(void)
+{
+	s3k_err_t err = setup_uart(UART_PMP);
+	if (err)
+		return -1;
+	err = setup_shared();
+	if (!err)
+		err = setup_app1();
+	if (err) {
+		alt_printf("setup error: 0x%X\n", err);
+		return -1;
+	}
+
+	alt_puts("sched churn: app1 resume latency in ticks");
+	s3k_mon_resume(MONITOR, APP1_PID);
+	while (__atomic_load_n(&SHARED->phase, __ATOMIC_ACQUIRE) == PHASE_IDLE)
+		;
+
+	uint64_t ops;
+	err = churn(&ops);
+	if (err) {
+		alt_printf("churn error: 0x%X\n", err);
+		return -1;
+	}
+	while (__atomic_load_n(&SHARED->phase, __ATOMIC_ACQUIRE) != PHASE_DONE)
+		;
+	print_result("idle ", &SHARED->res[PHASE_IDLE]);
+	print_result("churn", &SHARED->res[PHASE_CHURN]);
+	alt_printf("%d time capabilities derived and revoked\n", ops);
+}
@@ -0,0 +1,47 @@
+#include "../churn.h"
+
+static uint64_t samples[SAMPLES];
+
+static void sort(uint64_t *a, uint64_t n)
+{
+	for (uint64_t i = 1; i < n; i++) {
+		uint64_t x = a[i];
+		uint64_t j = i;
+		for (; j > 0 && a[j - 1] > x; j--)
+			a[j] = a[j - 1];
+		a[j] = x;
+	}
+}
+
+/// Spin until preempted, returns the ticks from the start of the slot we
+/// resume in to our first instruction there.
+static uint64_t resume_latency(void)
+{
+	uint64_t prev = s3k_get_time();
+	for (;;) {
+		uint64_t now = s3k_get_time();
+		// A gap of a slot or more is time spent off the hart.
+		if (now - prev >= S3K_SLOT_LEN)
+			return now % S3K_SLOT_LEN;
+		prev = now;
+	}
+}
+
+static void measure(volatile result_t *res)
+{
+	for (uint64_t i = 0; i < SAMPLES; i++)
+		samples[i] = resume_latency();
+	sort(samples, SAMPLES);
+	res->p50 = samples[SAMPLES / 2];
+	res->p90 = samples[SAMPLES * 90 / 100];
+	res->p99 = samples[SAMPLES * 99 / 100];
+	res->max = samples[SAMPLES - 1];
+}
+
+int main(void)
+{
+	measure(&SHARED->res[PHASE_IDLE]);
+	__atomic_store_n(&SHARED->phase, PHASE_CHURN, __ATOMIC_RELEASE);
+	measure(&SHARED->res[PHASE_CHURN]);
+	__atomic_store_n(&SHARED->phase, PHASE_DONE, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,46 @@
+/**
+ * Scheduling latency under time capability churn.
+ *
+ * app1 owns four slices of hart 1 per period and measures how late it runs
+ * after each slice starts. app0 on hart 0 meanwhile derives and revokes time
+ * capabilities of harts 1-3 as fast as it can, so the slot tables are
+ * rewritten while hart 1 schedules. app1 measures twice, without and with the
+ * churn, and app0 prints both. The latencies should be the same.
+ */
+#pragma once
+
+#include "altc/altio.h"
+#include "s3k/s3k.h"
+
+#define SHARED_BASE 0x80030000
+#define SHARED_SIZE 0x1000
+
+// Capabilities app0 gives app1.
+#define APP_MEM_PMP 0
+#define APP_SHARED_PMP 1
+#define APP_TIME 2
+
+// Slices of app1 on hart 1, SLICE_LEN slots every SLICE_STRIDE slots.
+#define CHURN_HART 1
+#define SLICE_CNT 4
+#define SLICE_LEN 4
+#define SLICE_STRIDE (S3K_SLOT_CNT / SLICE_CNT)
+
+#define SAMPLES 256
+
+typedef enum {
+	PHASE_IDLE,  // app1 measures, app0 waits.
+	PHASE_CHURN, // app1 measures, app0 churns.
+	PHASE_DONE,
+} phase_t;
+
+typedef struct result {
+	uint64_t p50, p90, p99, max;
+} result_t;
+
+typedef struct shared {
+	uint64_t phase;
+	result_t res[2];
+} shared_t;
+
+#define SHARED ((volatile shared_t *)SHARED_BASE)
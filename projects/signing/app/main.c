@@ -9,41 +9,28 @@
 
 s3k_cidx_t find_sign_client_cidx()
 {
-	for (s3k_cidx_t i = 0; i < S3K_CAP_CNT; i++) {
-		s3k_cap_t c;
-		s3k_err_t err = s3k_cap_read(i, &c);
-		if (err)
-			continue;
-		if (c.type == S3K_CAPTY_SOCKET && c.sock.chan == SIGN_CHANNEL) {
-			return i;
-		}
-	}
-	return S3K_CAP_CNT;
+	s3k_cidx_t i;
+	s3k_cap_t mask = {.sock.chan = -1};
+	s3k_cap_t val = {.sock.chan = SIGN_CHANNEL};
+	if (s3k_cap_find(0, S3K_CAPTY_SOCKET, mask.raw, val.raw, &i))
+		return S3K_CAP_CNT;
+	return i;
 }
 
 s3k_cidx_t find_path_cidx()
 {
-	for (s3k_cidx_t i = 0; i < S3K_CAP_CNT; i++) {
-		s3k_cap_t c;
-		s3k_err_t err = s3k_cap_read(i, &c);
-		if (err)
-			continue;
-		if (c.type == S3K_CAPTY_PATH) {
-			return i;
-		}
-	}
-	return S3K_CAP_CNT;
+	s3k_cidx_t i;
+	if (s3k_cap_find(0, S3K_CAPTY_PATH, 0, 0, &i))
+		return S3K_CAP_CNT;
+	return i;
 }
 
 s3k_cidx_t find_free_cidx()
 {
-	for (s3k_cidx_t i = 0; i < S3K_CAP_CNT; i++) {
-		s3k_cap_t c;
-		s3k_err_t err = s3k_cap_read(i, &c);
-		if (err == S3K_ERR_EMPTY)
-			return i;
-	}
-	return S3K_CAP_CNT;
+	s3k_cidx_t i;
+	if (s3k_cap_find_free(0, &i))
+		return S3K_CAP_CNT;
+	return i;
 }
 
 s3k_err_t read_pub_key(s3k_cidx_t pub_cidx, rsa_public_key_t *pub_key)
@@ -157,11 +157,11 @@ s3k_err_t setup_app(s3k_pid_t sign_pid, uint32_t sign_client_tag)
 	// SIGN CLIENT SOCKET
 	{
 		s3k_cidx_t server_cidx = 0;
+		s3k_cap_t caps[S3K_CAP_CNT];
+		SUCCESS_OR_RETURN_ERR(
+		    s3k_mon_cap_read_range(MONITOR, SIGN_PID, 0, caps, S3K_CAP_CNT));
 		for (size_t i = 0; i < S3K_CAP_CNT; i++) {
-			s3k_cap_t cap;
-			s3k_err_t err = s3k_mon_cap_read(MONITOR, SIGN_PID, i, &cap);
-			if (err)
-				continue;
+			s3k_cap_t cap = caps[i];
 			if (cap.type == S3K_CAPTY_SOCKET && cap.sock.chan == SIGN_CHANNEL) {
 				server_cidx = i;
 				break;
@@ -205,13 +205,15 @@ s3k_err_t setup_app(s3k_pid_t sign_pid, uint32_t sign_client_tag)
 
 s3k_cidx_t mon_find_free_cidx(s3k_cidx_t mon_idx, s3k_pid_t pid)
 {
+	s3k_cap_t caps[S3K_CAP_CNT];
+	s3k_err_t err = s3k_mon_cap_read_range(mon_idx, pid, 0, caps, S3K_CAP_CNT);
+	if (err) {
+		alt_printf("s3k_mon_cap_read_range error code: %x\n", err);
+		return S3K_CAP_CNT;
+	}
 	for (s3k_cidx_t i = 0; i < S3K_CAP_CNT; i++) {
-		s3k_cap_t c;
-		s3k_err_t err = s3k_mon_cap_read(mon_idx, pid, i, &c);
-		if (err == S3K_ERR_EMPTY)
+		if (caps[i].raw == 0)
 			return i;
-		if (err)
-			alt_printf("s3k_mon_cap_read error code: %x\n", err);
 	}
 	return S3K_CAP_CNT;
 }
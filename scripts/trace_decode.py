@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Decode kernel event trace records into per-hart timelines.
+
+The input is the records drained with s3k_mon_trace_read(), as raw
+little-endian s3k_trace_rec_t, e.g., saved from the monitor's buffer with gdb:
+
+    dump binary memory trace.bin buf buf+cnt*24
+
+Several files, or several drains concatenated, may be given. Times are
+printed in real-time clock ticks relative to the first record, with the
+difference to the previous record of the same hart.
+"""
+
+import argparse
+import struct
+import sys
+from collections import defaultdict
+
+REC = struct.Struct("<QIHBBQ")
+
+EVENTS = [
+    "sched",
+    "preempt",
+    "yield",
+    "syscall",
+    "syscall_ret",
+    "ipc_send",
+    "ipc_recv",
+    "exception",
+]
+
+# Keep in sync with common/inc/s3k/syscall.h
+SYSCALLS = [
+    "get_info", "reg_read", "reg_write", "sync", "cap_read", "cap_move",
+    "cap_delete", "cap_revoke", "cap_derive", "pmp_load", "pmp_unload",
+    "mon_suspend", "mon_resume", "mon_state_get", "mon_yield",
+    "mon_reg_read", "mon_reg_write", "mon_cap_read", "mon_cap_move",
+    "mon_pmp_load", "mon_pmp_unload", "sock_send", "sock_recv",
+    "sock_sendrecv", "path_read", "mon_path_read", "path_derive",
+    "read_file", "write_file", "create_dir", "path_delete", "read_dir",
+    "mon_slack_set", "sched_stage", "sched_commit", "mon_syshist_read",
+    "mon_acct_read", "mon_trace_read", "multicall", "cap_read_range",
+    "mon_cap_read_range", "cap_find", "cap_parent", "cap_descendants",
+]
+
+
+def records(files):
+    for f in files:
+        data = f.read()
+        if len(data) % REC.size:
+            sys.exit(f"{f.name}: size not a multiple of {REC.size}")
+        for off in range(0, len(data), REC.size):
+            yield REC.unpack_from(data, off)
+
+
+def describe(event, arg):
+    name = EVENTS[event] if event < len(EVENTS) else f"event{event}"
+    if name == "syscall":
+        return f"{name} {SYSCALLS[arg] if arg < len(SYSCALLS) else arg}"
+    if name == "exception":
+        return f"{name} mcause={arg:#x}"
+    if name in ("ipc_send", "ipc_recv"):
+        return f"{name} chan={arg}"
+    if name == "sched":
+        return f"{name} until={arg}"
+    if name == "syscall_ret":
+        return f"{name} err={arg}"
+    return name
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="+", type=argparse.FileType("rb"))
+    args = parser.parse_args()
+
+    harts = defaultdict(list)
+    for time, seq, pid, event, hart, arg in records(args.files):
+        harts[hart].append((seq, time, pid, event, arg))
+    if not harts:
+        return
+    t0 = min(rec[1] for recs in harts.values() for rec in recs)
+
+    for hart in sorted(harts):
+        print(f"hart {hart}:")
+        prev_seq = prev_time = None
+        for seq, time, pid, event, arg in sorted(harts[hart]):
+            if prev_seq is not None and seq != (prev_seq + 1) & 0xFFFFFFFF:
+                print(f"  -- {(seq - prev_seq - 1) & 0xFFFFFFFF} records lost")
+            delta = "" if prev_time is None else f"+{time - prev_time}"
+            print(f"  {time - t0:>12} {delta:>10}  pid {pid:<3} "
+                  f"{describe(event, arg)}")
+            prev_seq, prev_time = seq, time
+
+
+if __name__ == "__main__":
+    main()